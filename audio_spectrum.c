@@ -1,4 +1,6 @@
 #include "audio_spectrum.h"
+#include "pitch_detection.h"
+#include "spectral_peaks.h"
 
 
 // Window functions for spectral analysis
@@ -36,6 +38,63 @@ void apply_window_blackman(complex_t* signal, int n) {
     }
 }
 
+static const char* window_names[WINDOW_COUNT] = {"none", "hann", "hamming", "blackman"};
+
+void apply_window(complex_t* signal, int n, window_type_t window) {
+    switch (window) {
+    case WINDOW_HANN:     apply_window_hann(signal, n); break;
+    case WINDOW_HAMMING:  apply_window_hamming(signal, n); break;
+    case WINDOW_BLACKMAN: apply_window_blackman(signal, n); break;
+    default: break;
+    }
+}
+
+// Window coefficients for frame_window(), same values as apply_window()
+// (caller frees)
+double* window_table(int n, window_type_t window) {
+    complex_t* ones = allocate_complex_array(n);
+    double* table = (double*)fft_malloc(n * sizeof(double));
+    CHECK_NULL(ones, "Failed to allocate window");
+    CHECK_NULL(table, "Failed to allocate window");
+
+    for (int i = 0; i < n; i++) ones[i] = 1.0;
+    apply_window(ones, n, window);
+    for (int i = 0; i < n; i++) table[i] = creal(ones[i]);
+
+    free_complex_array(ones);
+    return table;
+}
+
+// Q15 copy of a window for the fixed-point path (caller frees)
+int16_t* window_table_q15(int n, window_type_t window) {
+    complex_t* ones = allocate_complex_array(n);
+    int16_t* table = (int16_t*)fft_malloc(n * sizeof(int16_t));
+    CHECK_NULL(ones, "Failed to allocate window");
+    CHECK_NULL(table, "Failed to allocate window");
+
+    for (int i = 0; i < n; i++) ones[i] = 1.0;
+    apply_window(ones, n, window);
+    for (int i = 0; i < n; i++) {
+        double w = round(creal(ones[i]) * 32768.0);
+        table[i] = (int16_t)fmax(-32768.0, fmin(32767.0, w));
+    }
+
+    free_complex_array(ones);
+    return table;
+}
+
+int window_from_name(const char* name) {
+    for (int i = 0; i < WINDOW_COUNT; i++) {
+        if (strcmp(name, window_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char* window_name(window_type_t window) {
+    if (window < 0 || window >= WINDOW_COUNT) return "unknown";
+    return window_names[window];
+}
+
 // Generate test audio signal
 void generate_test_audio(complex_t* signal, int n, double sample_rate) {
     // Generate a signal with multiple frequency components
@@ -58,34 +117,34 @@ double bin_to_frequency(int bin, int fft_size, double sample_rate) {
 }
 
 
+// Engine behind find_peaks, kept for the next call with the same size,
+// rate and peak count (analysis thread only)
+static peak_engine_t* peaks_engine = NULL;
+static int peaks_n = 0;
+static double peaks_rate = 0;
+static int peaks_max = 0;
+
+// Strongest local maxima above the local noise floor, strongest first
 void find_peaks(double* magnitude, int n, double sample_rate, 
                 peak_t* peaks, int* num_peaks, int max_peaks) {
     *num_peaks = 0;
-    double threshold = 0.1;  // Minimum magnitude threshold
-    
-    for (int i = 1; i < n/2 - 1 && *num_peaks < max_peaks; i++) {
-        // Check if local maximum
-        if (magnitude[i] > magnitude[i-1] && 
-            magnitude[i] > magnitude[i+1] &&
-            magnitude[i] > threshold) {
-            
-            peaks[*num_peaks].bin = i;
-            peaks[*num_peaks].frequency = bin_to_frequency(i, n, sample_rate);
-            peaks[*num_peaks].magnitude = magnitude[i];
-            (*num_peaks)++;
-        }
-    }
-    
-    // Sort peaks by magnitude (simple bubble sort)
-    for (int i = 0; i < *num_peaks - 1; i++) {
-        for (int j = 0; j < *num_peaks - i - 1; j++) {
-            if (peaks[j].magnitude < peaks[j+1].magnitude) {
-                peak_t temp = peaks[j];
-                peaks[j] = peaks[j+1];
-                peaks[j+1] = temp;
-            }
-        }
+    if (max_peaks <= 0) return;
+    if (peaks_engine == NULL || peaks_n != n || peaks_rate != sample_rate || peaks_max != max_peaks) {
+        peak_engine_free(peaks_engine);
+        peak_config_t config = peak_default_config();
+        config.max_peaks = max_peaks;
+        peaks_engine = peak_engine_create(n, sample_rate, &config);
+        peaks_n = n;
+        peaks_rate = sample_rate;
+        peaks_max = max_peaks;
     }
+    *num_peaks = peak_engine_run_magnitude(peaks_engine, magnitude, peaks);
+}
+
+// Release the engine cached by find_peaks
+void find_peaks_cleanup(void) {
+    peak_engine_free(peaks_engine);
+    peaks_engine = NULL;
 }
 
 // Display spectrum as ASCII art
@@ -148,7 +207,35 @@ void analyze_audio_spectrum(complex_t* signal, int n, double sample_rate,
     // Display spectrum
     display_spectrum_ascii(magnitude, n, sample_rate);
     
-    free(magnitude);
+    fft_free(magnitude);
 }
 
 
+
+
+// Spectrum of a whole recording, zero-padded to a power of two. Sizes of
+// 2^20 and more go to the six-step engine through radix2_dit_fft.
+void analyze_recording_spectrum(const int16_t* samples, uint32_t count, double sample_rate) {
+    int n = next_power_of_two((int)count);
+    complex_t* signal = allocate_complex_array(n);
+    CHECK_NULL(signal, "Failed to allocate recording buffer");
+
+    for (uint32_t i = 0; i < count; i++) {
+        signal[i] = (double)samples[i];
+    }
+    apply_window_hann(signal, (int)count);
+
+    radix2_dit_fft(signal, n, FFT_FORWARD);
+
+    double pitch_peak = detect_pitch_peak(signal, n, sample_rate);
+    double pitch_hps = detect_pitch_hps(signal, n, sample_rate, 5);
+
+    printf("\nRecording Spectrum:\n");
+    printf("===================\n");
+    printf("FFT size: %d (%s engine), resolution: %.4f Hz\n",
+           n, fft_engine_name(fft_engine_for(n, FFT_FORWARD)), sample_rate / n);
+    printf("Strongest peak: %.3f Hz, %s\n", pitch_peak, frequency_to_note_name(pitch_peak));
+    printf("HPS pitch: %.3f Hz, %s\n", pitch_hps, frequency_to_note_name(pitch_hps));
+
+    free_complex_array(signal);
+}
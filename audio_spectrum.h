@@ -1,5 +1,6 @@
 #ifndef AUDIO_SPECTRUM_H
 #define AUDIO_SPECTRUM_H
+#include <stdint.h>
 #include "fft_common.h"
 #include "fft_algorithms.h"
 
@@ -32,17 +33,32 @@ typedef struct {
     int bin;
 } peak_t;
 
+typedef enum {
+    WINDOW_NONE = 0,
+    WINDOW_HANN,
+    WINDOW_HAMMING,
+    WINDOW_BLACKMAN,
+    WINDOW_COUNT
+} window_type_t;
+
 void apply_window_hann(complex_t* signal, int n);
 complex_t* compute_ndft(complex_t* signal, int n,double *fundamentals, int k);
 void apply_window_hamming(complex_t* signal, int n);
 void apply_window_blackman(complex_t* signal, int n);
+void apply_window(complex_t* signal, int n, window_type_t window);
+double* window_table(int n, window_type_t window);
+int16_t* window_table_q15(int n, window_type_t window);
+int window_from_name(const char* name);
+const char* window_name(window_type_t window);
 void generate_test_audio(complex_t* signal, int n, double sample_rate);
 double bin_to_frequency(int bin, int fft_size, double sample_rate);
 void find_peaks(double* magnitude, int n, double sample_rate, 
                 peak_t* peaks, int* num_peaks, int max_peaks);
+void find_peaks_cleanup(void);
 void display_spectrum_ascii(double* magnitude, int n, double sample_rate);
 void analyze_audio_spectrum(complex_t* signal, int n, double sample_rate, 
                           const char* window_type);
+void analyze_recording_spectrum(const int16_t* samples, uint32_t count, double sample_rate);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "wavformat.h"
+#include "prefetch.h"
+#include "stats.h"
+
+#define CORPUS_PATH_MAX 4096
+#define CORPUS_MAX_GENERATIONS 1000
+
+typedef struct {
+    char** paths;
+    int count;
+} manifest_t;
+
+corpus_config_t corpus_default_config(void) {
+    corpus_config_t config;
+    config.manifest = NULL;
+    config.out_dir = NULL;
+    config.extension = "csv";
+    config.shard_size = 64;
+    config.lease_seconds = 3600;
+    config.prefetch = PREFETCH_DEFAULT_DEPTH;
+    return config;
+}
+
+static void manifest_free(manifest_t* manifest);
+
+static bool manifest_load(const char* path, manifest_t* manifest) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        PRINT_ERROR("%s: Failed to open manifest", path);
+        return false;
+    }
+    int capacity = 256;
+    manifest->count = 0;
+    manifest->paths = malloc(capacity * sizeof(char*));
+    if (manifest->paths == NULL) {
+        fclose(file);
+        return false;
+    }
+
+    char line[CORPUS_PATH_MAX];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+        if (manifest->count == capacity) {
+            capacity *= 2;
+            char** grown = realloc(manifest->paths, capacity * sizeof(char*));
+            if (grown == NULL) break;
+            manifest->paths = grown;
+        }
+        manifest->paths[manifest->count] = strdup(line);
+        if (manifest->paths[manifest->count] == NULL) break;
+        manifest->count++;
+    }
+    bool ok = !ferror(file) && feof(file);
+    fclose(file);
+    if (!ok) {
+        PRINT_ERROR("%s: Failed to read manifest", path);
+        manifest_free(manifest);
+    }
+    return ok;
+}
+
+static void manifest_free(manifest_t* manifest) {
+    for (int i = 0; i < manifest->count; i++) {
+        free(manifest->paths[i]);
+    }
+    free(manifest->paths);
+}
+
+static void claim_path(const corpus_config_t* config, int shard, int generation, char* path) {
+    snprintf(path, CORPUS_PATH_MAX, "%s/shard-%05d.claim.%d", config->out_dir, shard, generation);
+}
+
+static void done_path(const corpus_config_t* config, int shard, char* path) {
+    snprintf(path, CORPUS_PATH_MAX, "%s/shard-%05d.done", config->out_dir, shard);
+}
+
+// Result file for manifest entry `index`: <out_dir>/<index>-<basename>.<ext>
+static void result_path(const corpus_config_t* config, int index, const char* wav_path, char* path) {
+    const char* base = strrchr(wav_path, '/');
+    base = base ? base + 1 : wav_path;
+    int len = (int)strcspn(base, ".");
+    snprintf(path, CORPUS_PATH_MAX, "%s/%06d-%.*s.%s", config->out_dir, index, len, base,
+             config->extension);
+}
+
+// Mark the entries of a shard already listed in its checkpoint file. A
+// line only counts when its path is still the manifest's entry at that
+// index, so an edited manifest does not skip the wrong file.
+static int load_checkpoint(const corpus_config_t* config, int shard, int first, int count,
+                           char* const* paths, bool* done) {
+    char path[CORPUS_PATH_MAX];
+    done_path(config, shard, path);
+    memset(done, 0, count * sizeof(bool));
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return 0;
+
+    int completed = 0;
+    char line[CORPUS_PATH_MAX + 32];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        int index;
+        // A torn last line (crash during the write) has no newline: ignore it
+        char* end = strchr(line, '\n');
+        char* tab = strchr(line, '\t');
+        if (end == NULL || tab == NULL || sscanf(line, "%d", &index) != 1) continue;
+        *end = '\0';
+        if (index >= first && index < first + count && !done[index - first] &&
+            strcmp(tab + 1, paths[index]) == 0) {
+            done[index - first] = true;
+            completed++;
+        }
+    }
+    fclose(file);
+    return completed;
+}
+
+static bool append_checkpoint(const corpus_config_t* config, int shard, int index, const char* wav_path) {
+    char path[CORPUS_PATH_MAX];
+    char line[CORPUS_PATH_MAX + 32];
+    done_path(config, shard, path);
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        PRINT_ERROR("%s: Failed to open checkpoint", path);
+        return false;
+    }
+    int len = snprintf(line, sizeof(line), "%d\t%s\n", index, wav_path);
+    bool ok = write(fd, line, len) == len && fsync(fd) == 0;
+    close(fd);
+    if (!ok) {
+        PRINT_ERROR("%s: Failed to write checkpoint", path);
+    }
+    return ok;
+}
+
+// Highest existing claim generation of a shard, -1 if it was never claimed
+static int current_generation(const corpus_config_t* config, int shard, struct stat* st) {
+    char path[CORPUS_PATH_MAX];
+    int generation = -1;
+    for (int g = 0; g < CORPUS_MAX_GENERATIONS; g++) {
+        struct stat s;
+        claim_path(config, shard, g, path);
+        if (stat(path, &s) != 0) break;
+        generation = g;
+        *st = s;
+    }
+    return generation;
+}
+
+// True when a claim was written by a process on this host that no longer
+// exists (a crashed or killed run): its lease need not run out first
+static bool claim_owner_gone(const corpus_config_t* config, int shard, int generation) {
+    char path[CORPUS_PATH_MAX];
+    char owner[256];
+    char host[256] = "unknown";
+    long pid;
+    claim_path(config, shard, generation, path);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return false;
+    bool parsed = fscanf(file, "%255s %ld", owner, &pid) == 2;
+    fclose(file);
+    gethostname(host, sizeof(host) - 1);
+    return parsed && strcmp(owner, host) == 0 && pid != (long)getpid() &&
+           kill((pid_t)pid, 0) != 0 && errno == ESRCH;
+}
+
+// Claim a shard that is unclaimed, released, or whose owner stopped
+// refreshing its claim or is gone; returns the generation now owned, or -1
+static int claim_shard(const corpus_config_t* config, int shard) {
+    struct stat st = {0};
+    int generation = current_generation(config, shard, &st);
+    if (generation >= 0 && time(NULL) - st.st_mtime < config->lease_seconds &&
+        !claim_owner_gone(config, shard, generation)) {
+        return -1;
+    }
+    generation++;
+    if (generation >= CORPUS_MAX_GENERATIONS) return -1;
+
+    char path[CORPUS_PATH_MAX];
+    claim_path(config, shard, generation, path);
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        if (errno != EEXIST) {
+            PRINT_ERROR("%s: Failed to create claim", path);
+        }
+        return -1;    // another worker got there first
+    }
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    char owner[512];
+    int len = snprintf(owner, sizeof(owner), "%s %ld %ld\n", host, (long)getpid(), (long)time(NULL));
+    if (write(fd, owner, len) != len) {
+        PRINT_ERROR("%s: Failed to write claim", path);
+    }
+    close(fd);
+    return generation;
+}
+
+// Refresh the lease; false once a newer generation took the shard over
+static bool keep_claim(const corpus_config_t* config, int shard, int generation) {
+    char path[CORPUS_PATH_MAX];
+    struct stat st;
+    claim_path(config, shard, generation + 1, path);
+    if (stat(path, &st) == 0) return false;
+    claim_path(config, shard, generation, path);
+    return utimensat(AT_FDCWD, path, NULL, 0) == 0;
+}
+
+// Give the shard back once this worker is done with it (finished, failed
+// entries or not): the claim is dated past the lease, so the next run can
+// take it over at once. The generation stays, so a previous owner still
+// sees it was taken over.
+static void release_claim(const corpus_config_t* config, int shard, int generation) {
+    char path[CORPUS_PATH_MAX];
+    struct timespec times[2];
+    times[0].tv_sec = time(NULL) - config->lease_seconds - 1;
+    times[0].tv_nsec = 0;
+    times[1] = times[0];
+    claim_path(config, shard, generation, path);
+    if (utimensat(AT_FDCWD, path, times, 0) != 0) {
+        PRINT_ERROR("%s: Failed to release claim", path);
+    }
+}
+
+// Work through every shard this worker can claim, starting at a
+// pid-dependent shard so concurrent workers spread out
+bool corpus_run(const corpus_config_t* config, corpus_process_fn process, void* ctx) {
+    manifest_t manifest;
+    if (config->shard_size <= 0 || !manifest_load(config->manifest, &manifest)) {
+        return false;
+    }
+    if (mkdir(config->out_dir, 0755) != 0 && errno != EEXIST) {
+        PRINT_ERROR("%s: Failed to create output directory", config->out_dir);
+        manifest_free(&manifest);
+        return false;
+    }
+
+    int shards = (manifest.count + config->shard_size - 1) / config->shard_size;
+    bool* done = malloc(config->shard_size * sizeof(bool));
+    const char** pending_paths = malloc(config->shard_size * sizeof(char*));
+    int* pending_index = malloc(config->shard_size * sizeof(int));
+    if (done == NULL || pending_paths == NULL || pending_index == NULL) {
+        free(done);
+        free(pending_paths);
+        free(pending_index);
+        manifest_free(&manifest);
+        return false;
+    }
+
+    int processed = 0, resumed = 0, failed = 0, claimed = 0, busy = 0;
+    int start = shards > 0 ? (int)(getpid() % shards) : 0;
+    for (int s = 0; s < shards; s++) {
+        int shard = (start + s) % shards;
+        int first = shard * config->shard_size;
+        int count = manifest.count - first;
+        if (count > config->shard_size) count = config->shard_size;
+
+        int completed = load_checkpoint(config, shard, first, count, manifest.paths, done);
+        if (completed == count) continue;
+        int generation = claim_shard(config, shard);
+        if (generation < 0) {
+            // Left to whoever holds the claim
+            busy += count - completed;
+            continue;
+        }
+        claimed++;
+
+        // Re-read under the claim: a previous owner may have added entries
+        completed = load_checkpoint(config, shard, first, count, manifest.paths, done);
+        resumed += completed;
+        int pending_count = 0;
+        for (int i = 0; i < count; i++) {
+            if (done[i]) continue;
+            pending_paths[pending_count] = manifest.paths[first + i];
+            pending_index[pending_count++] = first + i;
+        }
+
+        // The next entries are read while the current one is analyzed;
+        // without a prefetcher the process callback loads them itself
+        prefetch_t* prefetch = NULL;
+        if (config->prefetch > 0) {
+            prefetch = prefetch_open(pending_paths, pending_count, config->prefetch, PREFETCH_MAX_BYTES);
+        }
+        for (int k = 0; k < pending_count; k++) {
+            if (!keep_claim(config, shard, generation)) {
+                fprintf(stderr, "Shard %d was taken over, leaving it\n", shard);
+                busy += pending_count - k;
+                generation = -1;
+                break;
+            }
+            int index = pending_index[k];
+            sound_t sound;
+            sound_t* preloaded = NULL;
+            bool loaded = true;
+            if (prefetch != NULL) {
+                int position;
+                STATS_BEGIN(load_span);    // time spent waiting on the reader
+                prefetch_next(prefetch, &position, &sound, &loaded);
+                STATS_END(STATS_LOAD, load_span);
+                preloaded = &sound;
+            }
+
+            char final_path[CORPUS_PATH_MAX];
+            char temp_path[CORPUS_PATH_MAX + 32];
+            result_path(config, index, manifest.paths[index], final_path);
+            snprintf(temp_path, sizeof(temp_path), "%s.%ld.tmp", final_path, (long)getpid());
+
+            if (loaded && process(manifest.paths[index], preloaded, temp_path, ctx) &&
+                rename(temp_path, final_path) == 0 &&
+                append_checkpoint(config, shard, index, manifest.paths[index])) {
+                processed++;
+            } else {
+                PRINT_ERROR("%s: analysis failed, left for the next run", manifest.paths[index]);
+                remove(temp_path);
+                failed++;
+            }
+        }
+        prefetch_close(prefetch);
+        if (generation >= 0) {
+            release_claim(config, shard, generation);
+        }
+    }
+
+    fprintf(stderr, "Corpus: %d files in %d shards; this worker claimed %d shards, "
+                    "analyzed %d files (%d already checkpointed), %d failed, "
+                    "%d left under other workers' claims\n",
+            manifest.count, shards, claimed, processed, resumed, failed, busy);
+    free(pending_index);
+    free(pending_paths);
+    free(done);
+    manifest_free(&manifest);
+    return failed == 0 && busy == 0;
+}
@@ -0,0 +1,42 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdbool.h>
+#include "wavformat.h"
+
+// Resumable corpus runs. The manifest (one WAV path per line, '#'
+// comments) is split into fixed-size shards that any number of worker
+// processes, on one host or several sharing the output directory, claim
+// with O_EXCL-created claim files:
+//
+//   <out_dir>/shard-00003.claim.<generation>   owner: host, pid, time
+//   <out_dir>/shard-00003.done                 checkpoint: one line per file
+//
+// The owner touches its claim after every file and releases it (dates it
+// past the lease) when it leaves the shard, so failed entries are retried
+// by the next run. A claim that has not been touched for lease_seconds, or
+// whose owner on this host has exited, is taken over by creating the next
+// generation, which only one worker can do; the previous owner sees the
+// newer claim and stops. corpus_run fails while entries are left under
+// other workers' claims. Results are written under a temporary name and renamed before
+// the file is checkpointed, so a restarted run redoes at most the file that
+// was in flight.
+
+// Analyze one recording into out_path; false leaves it for the next run.
+// `sound` is the already loaded recording (the callback owns its data),
+// or NULL when the callback has to load it itself.
+typedef bool (*corpus_process_fn)(const char* wav_path, sound_t* sound, const char* out_path, void* ctx);
+
+typedef struct {
+    const char* manifest;
+    const char* out_dir;
+    const char* extension;    // result file extension, without the dot
+    int shard_size;           // manifest entries per shard
+    int lease_seconds;        // claims idle this long may be taken over
+    int prefetch;             // recordings loaded ahead (0: load inline)
+} corpus_config_t;
+
+corpus_config_t corpus_default_config(void);
+bool corpus_run(const corpus_config_t* config, corpus_process_fn process, void* ctx);
+
+#endif
@@ -8,8 +8,62 @@
  * This allows algorithms to use each other without circular dependencies
  */
 
+/* Engines available behind radix2_dit_fft() */
+typedef enum {
+    FFT_ENGINE_AUTO = 0,       /* let the library choose per size */
+    FFT_ENGINE_RADIX2,         /* iterative radix-2 DIT, plain bit reversal */
+    FFT_ENGINE_RADIX2_COBRA,   /* radix-2 DIT with cache-blocked bit reversal */
+    FFT_ENGINE_STOCKHAM,       /* out-of-place Stockham autosort */
+    FFT_ENGINE_SIXSTEP,        /* cache-blocked, multithreaded six-step */
+    FFT_ENGINE_CODELET,        /* size-specialized kernels, radix-2 fallback */
+    FFT_ENGINE_COUNT
+} fft_engine_t;
+
 /* Core FFT algorithms */
 void radix2_dit_fft(complex_t* x, int n, fft_direction dir);
+void stockham_fft(complex_t* x, int n, fft_direction dir);
+void stockham_fft_buffer(complex_t* x, complex_t* y, int n, fft_direction dir);
+void bit_reverse_permute_cobra(complex_t* x, int n);
+void fft_sixstep(complex_t* x, int n, fft_direction dir);
+void fft_sixstep_buffer(complex_t* x, complex_t* y, int n, fft_direction dir);
+int fft_codelet(complex_t* x, int n, fft_direction dir);
+int fft_codelet_available(int n);
+void fft_set_threads(int threads);
+int fft_get_threads(void);
+
+/* Sizes from which FFT_ENGINE_AUTO switches to the six-step engine */
+#define FFT_SIXSTEP_MIN_N (1 << 20)
+
+/* Engine selection and shared tables */
+void fft_set_engine(fft_engine_t engine);
+fft_engine_t fft_get_engine(void);
+fft_engine_t fft_engine_for(int n, fft_direction dir);
+const char* fft_engine_name(fft_engine_t engine);
+int fft_engine_from_name(const char* name);
+const complex_t* fft_twiddles(int n, fft_direction dir);
+const cq15_t* fft_twiddles_q15(int n, fft_direction dir);
+void fft_engine_cleanup(void);
+
+/* Autotuning: measured engine per (n, direction), persisted as wisdom */
+void fft_autotune(int min_n, int max_n, FILE* report);
+fft_engine_t fft_wisdom_lookup(int n, fft_direction dir);
+bool fft_wisdom_load(const char* path);
+bool fft_wisdom_save(const char* path);
+void fft_wisdom_forget(void);
+
+/* Chirp-z: spectrum on the grid f0 + k*df, k < m */
+void czt_zoom(const complex_t* x, int n, double f0, double df, int m,
+              double sample_rate, complex_t* out);
+
+/* Fixed-point (Q15, block floating point) transform and frame loading */
+int fft_fixed_q15(cq15_t* x, int n, fft_direction dir);
+int fft_fixed_load_q15(const int16_t* samples, uint32_t count, uint32_t start, int n,
+                       const int16_t* window, cq15_t* out);
+
+/* Batched transforms, frame-interleaved layout: x[i * batch + b] */
+void fft_many(complex_t* x, int n, int batch, fft_direction dir);
+void fft_many_interleave(complex_t* const* frames, int n, int batch, complex_t* x);
+void fft_many_extract(const complex_t* x, int n, int batch, int b, complex_t* frame);
 
 /* Convenience wrappers */
 void fft_radix2_dit(complex_t* x, int n);
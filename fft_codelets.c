@@ -0,0 +1,208 @@
+#include "fft_common.h"
+#include "fft_algorithms.h"
+
+/**
+ * @file fft_codelets.c
+ * @brief Size-specialized FFT kernels for the frame sizes used in analysis
+ *
+ * @details
+ * Pitch analysis only runs a handful of transform sizes, so each of them
+ * gets its own instantiation of one kernel body with n and the direction
+ * known at compile time (FFT_CODELET below). Constant trip counts and
+ * strides let the compiler unroll and strength-reduce every loop.
+ *
+ * Kernel layout (decimation in time, after the cache-blocked bit
+ * reversal):
+ * 1. Radix-8 leaves: the first three radix-2 stages of every group of
+ *    eight are done as one straight-line DFT-8 whose twiddles (1, W8,
+ *    W4, W8^3) are constants folded into adds and one multiply by 1/sqrt(2).
+ * 2. Radix-4 passes: two radix-2 stages per pass over the data, halving
+ *    the number of passes. The W4 rotation is a swap and sign change.
+ * 3. One radix-2 pass if an odd number of stages is left.
+ *
+ * Complex products are written out by hand (cmul) so no path goes
+ * through the library's NaN/Inf-checking complex multiply.
+ *
+ * References:
+ * [1] Frigo, M. (1999). "A fast Fourier transform compiler"
+ * [2] Duhamel, P., & Vetterli, M. (1990). "Fast Fourier transforms: a
+ *     tutorial review and a state of the art"
+ */
+
+#define SQRT1_2 0.70710678118654752440
+
+static FORCE_INLINE complex_t cmul(complex_t a, complex_t b) {
+    double ar = creal(a), ai = cimag(a);
+    double br = creal(b), bi = cimag(b);
+    return CMPLX(ar * br - ai * bi, ar * bi + ai * br);
+}
+
+/* z * W4: -i*z forward, +i*z inverse */
+static FORCE_INLINE complex_t mul_w4(complex_t z, int inverse) {
+    return inverse ? CMPLX(-cimag(z), creal(z)) : CMPLX(cimag(z), -creal(z));
+}
+
+/* z * W8 = z * (1 -/+ i) / sqrt(2) */
+static FORCE_INLINE complex_t mul_w8(complex_t z, int inverse) {
+    double re = creal(z), im = cimag(z);
+    return inverse ? CMPLX((re - im) * SQRT1_2, (re + im) * SQRT1_2)
+                   : CMPLX((re + im) * SQRT1_2, (im - re) * SQRT1_2);
+}
+
+/* z * W8^3 = z * (-1 -/+ i) / sqrt(2) */
+static FORCE_INLINE complex_t mul_w8_3(complex_t z, int inverse) {
+    double re = creal(z), im = cimag(z);
+    return inverse ? CMPLX(-(re + im) * SQRT1_2, (re - im) * SQRT1_2)
+                   : CMPLX((im - re) * SQRT1_2, -(re + im) * SQRT1_2);
+}
+
+/* DFT-8 of a bit-reversed group, result in natural order */
+static FORCE_INLINE void leaf8(complex_t* y, int inverse) {
+    /* Stage 1: pairs one apart */
+    complex_t a0 = y[0] + y[1], a1 = y[0] - y[1];
+    complex_t a2 = y[2] + y[3], a3 = y[2] - y[3];
+    complex_t a4 = y[4] + y[5], a5 = y[4] - y[5];
+    complex_t a6 = y[6] + y[7], a7 = y[6] - y[7];
+
+    /* Stage 2: pairs two apart, twiddles 1 and W4 */
+    a3 = mul_w4(a3, inverse);
+    a7 = mul_w4(a7, inverse);
+    complex_t b0 = a0 + a2, b2 = a0 - a2;
+    complex_t b1 = a1 + a3, b3 = a1 - a3;
+    complex_t b4 = a4 + a6, b6 = a4 - a6;
+    complex_t b5 = a5 + a7, b7 = a5 - a7;
+
+    /* Stage 3: pairs four apart, twiddles 1, W8, W4, W8^3 */
+    b5 = mul_w8(b5, inverse);
+    b6 = mul_w4(b6, inverse);
+    b7 = mul_w8_3(b7, inverse);
+    y[0] = b0 + b4; y[4] = b0 - b4;
+    y[1] = b1 + b5; y[5] = b1 - b5;
+    y[2] = b2 + b6; y[6] = b2 - b6;
+    y[3] = b3 + b7; y[7] = b3 - b7;
+}
+
+/* Two DIT stages at once: sub-transforms of size h -> 4h */
+static FORCE_INLINE void radix4_pass(complex_t* x, const complex_t* tw, int n, int h, int inverse) {
+    int s1 = n / (2 * h);   /* table stride for W_2h */
+    int s2 = n / (4 * h);   /* table stride for W_4h */
+    for (int k = 0; k < n; k += 4 * h) {
+        complex_t* p = x + k;
+        for (int j = 0; j < h; j++) {
+            complex_t w1 = tw[j * s1];
+            complex_t w2 = tw[j * s2];
+            complex_t t1 = cmul(p[j + h], w1);
+            complex_t t3 = cmul(p[j + 3 * h], w1);
+            complex_t b0 = p[j] + t1, b1 = p[j] - t1;
+            complex_t b2 = p[j + 2 * h] + t3, b3 = p[j + 2 * h] - t3;
+            complex_t u2 = cmul(b2, w2);
+            complex_t u3 = mul_w4(cmul(b3, w2), inverse);
+            p[j] = b0 + u2;
+            p[j + 2 * h] = b0 - u2;
+            p[j + h] = b1 + u3;
+            p[j + 3 * h] = b1 - u3;
+        }
+    }
+}
+
+/* One DIT stage: sub-transforms of size h -> 2h */
+static FORCE_INLINE void radix2_pass(complex_t* x, const complex_t* tw, int n, int h) {
+    int s = n / (2 * h);
+    for (int k = 0; k < n; k += 2 * h) {
+        complex_t* p = x + k;
+        for (int j = 0; j < h; j++) {
+            complex_t t = cmul(p[j + h], tw[j * s]);
+            p[j + h] = p[j] - t;
+            p[j] = p[j] + t;
+        }
+    }
+}
+
+static FORCE_INLINE void codelet_body(complex_t* x, const int n, const int log2n, const int inverse) {
+    const complex_t* tw = fft_twiddles(n, inverse ? FFT_INVERSE : FFT_FORWARD);
+
+    bit_reverse_permute_cobra(x, n);
+
+    for (int k = 0; k < n; k += 8) {
+        leaf8(x + k, inverse);
+    }
+
+    int h = 8;
+    if ((log2n - 3) & 1) {
+        radix2_pass(x, tw, n, h);
+        h *= 2;
+    }
+    for (; h < n; h *= 4) {
+        radix4_pass(x, tw, n, h, inverse);
+    }
+
+    if (inverse) {
+        const double scale = 1.0 / n;
+        for (int i = 0; i < n; i++) {
+            x[i] *= scale;
+        }
+    }
+}
+
+/* One forward and one inverse kernel per size */
+#define FFT_CODELET(N, LOG2N)                                         \
+    static void fft_codelet_##N##_forward(complex_t* x) {             \
+        codelet_body(x, N, LOG2N, 0);                                 \
+    }                                                                 \
+    static void fft_codelet_##N##_inverse(complex_t* x) {             \
+        codelet_body(x, N, LOG2N, 1);                                 \
+    }
+
+FFT_CODELET(1024, 10)
+FFT_CODELET(2048, 11)
+FFT_CODELET(4096, 12)
+FFT_CODELET(8192, 13)
+
+typedef void (*codelet_fn)(complex_t* x);
+
+typedef struct {
+    int n;
+    codelet_fn forward;
+    codelet_fn inverse;
+} codelet_entry_t;
+
+static const codelet_entry_t codelets[] = {
+    {1024, fft_codelet_1024_forward, fft_codelet_1024_inverse},
+    {2048, fft_codelet_2048_forward, fft_codelet_2048_inverse},
+    {4096, fft_codelet_4096_forward, fft_codelet_4096_inverse},
+    {8192, fft_codelet_8192_forward, fft_codelet_8192_inverse},
+};
+
+#define NUM_CODELETS ((int)(sizeof(codelets) / sizeof(codelets[0])))
+
+/**
+ * @brief Whether a specialized kernel exists for size n
+ */
+int fft_codelet_available(int n) {
+    for (int i = 0; i < NUM_CODELETS; i++) {
+        if (codelets[i].n == n) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Run the specialized kernel for size n, if there is one
+ *
+ * @param x Input/output array of complex numbers
+ * @param n Length of array
+ * @param dir Transform direction (FFT_FORWARD or FFT_INVERSE)
+ * @return 1 if the transform was done, 0 if n has no codelet
+ */
+int fft_codelet(complex_t* x, int n, fft_direction dir) {
+    for (int i = 0; i < NUM_CODELETS; i++) {
+        if (codelets[i].n == n) {
+            if (dir == FFT_FORWARD) {
+                codelets[i].forward(x);
+            } else {
+                codelets[i].inverse(x);
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
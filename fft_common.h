@@ -8,6 +8,8 @@
 #include <time.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
+#include "stats.h"
 
 // Compiler optimization hints
 #ifdef __GNUC__
@@ -20,6 +22,13 @@
     #define FORCE_INLINE inline
 #endif
 
+// Compile a function for several ISAs and pick one at load time
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+    #define FFT_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+    #define FFT_TARGET_CLONES
+#endif
+
 // Constants
 #define PI 3.14159265358979323846
 #define TWO_PI (2.0 * PI)
@@ -27,6 +36,13 @@
 // Complex number type
 typedef double complex complex_t;
 
+// Fixed-point complex sample (Q15). A block of them shares one exponent,
+// see fft_fixed_q15()
+typedef struct {
+    int16_t re;
+    int16_t im;
+} cq15_t;
+
 // FFT direction
 typedef enum {
     FFT_FORWARD = -1,
@@ -55,34 +71,25 @@ static inline int log2_int(int n) {
     return log;
 }
 
-// Bit reversal function with optimization for small sizes
+// Bit reversal by swapping progressively larger bit groups (constant cost
+// for every size, no per-bit loop)
 static inline unsigned int bit_reverse(unsigned int x, int log2n) {
-    // Optimized bit reversal for common small sizes
-    if (log2n <= 8) {
-        // Use bit manipulation tricks for small sizes
-        x = ((x & 0xAAAA) >> 1) | ((x & 0x5555) << 1);
-        x = ((x & 0xCCCC) >> 2) | ((x & 0x3333) << 2);
-        x = ((x & 0xF0F0) >> 4) | ((x & 0x0F0F) << 4);
-        if (log2n > 4) x = ((x & 0xFF00) >> 8) | ((x & 0x00FF) << 8);
-        return x >> (16 - log2n);
-    }
-    
-    // General case for larger sizes
-    unsigned int r = 0;
-    for (int i = 0; i < log2n; i++) {
-        r = (r << 1) | (x & 1);
-        x >>= 1;
-    }
-    return r;
+    if (UNLIKELY(log2n == 0)) return 0;
+    x = ((x & 0xAAAAAAAAu) >> 1) | ((x & 0x55555555u) << 1);
+    x = ((x & 0xCCCCCCCCu) >> 2) | ((x & 0x33333333u) << 2);
+    x = ((x & 0xF0F0F0F0u) >> 4) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x & 0xFF00FF00u) >> 8) | ((x & 0x00FF00FFu) << 8);
+    x = (x >> 16) | (x << 16);
+    return x >> (32 - log2n);
 }
 
 // Memory allocation helpers
 static inline complex_t* allocate_complex_array(int n) {
-    return (complex_t*)calloc(n, sizeof(complex_t));
+    return (complex_t*)fft_calloc(n, sizeof(complex_t));
 }
 
 static inline void free_complex_array(complex_t* arr) {
-    if (arr) free(arr);
+    if (arr) fft_free(arr);
 }
 
 // Twiddle factor computation with optimization for common cases
@@ -165,7 +172,7 @@ static inline void generate_impulse(complex_t* signal, int n) {
 
 // Magnitude and phase utilities
 static inline double* compute_magnitude(complex_t* fft_result, int n) {
-    double* mag = (double*)malloc(n * sizeof(double));
+    double* mag = (double*)fft_malloc(n * sizeof(double));
     CHECK_NULL(mag, "Failed to allocate magnitude array");
     
     for (int i = 0; i < n; i++) {
@@ -175,7 +182,7 @@ static inline double* compute_magnitude(complex_t* fft_result, int n) {
 }
 
 static inline double* compute_phase(complex_t* fft_result, int n) {
-    double* phase = (double*)malloc(n * sizeof(double));
+    double* phase = (double*)fft_malloc(n * sizeof(double));
     CHECK_NULL(phase, "Failed to allocate phase array");
     
     for (int i = 0; i < n; i++) {
@@ -185,7 +192,7 @@ static inline double* compute_phase(complex_t* fft_result, int n) {
 }
 
 static inline double* compute_power_spectrum(complex_t* fft_result, int n) {
-    double* power = (double*)malloc(n * sizeof(double));
+    double* power = (double*)fft_malloc(n * sizeof(double));
     CHECK_NULL(power, "Failed to allocate power spectrum array");
     
     for (int i = 0; i < n; i++) {
@@ -0,0 +1,165 @@
+#include <pthread.h>
+#include "fft_common.h"
+#include "fft_algorithms.h"
+
+/**
+ * @file fft_engine.c
+ * @brief FFT engine selection and shared twiddle tables
+ *
+ * @details
+ * Every transform goes through radix2_dit_fft(), which asks this module
+ * which engine to run for the given size. The default (FFT_ENGINE_AUTO)
+ * runs the size-specialized codelets for the frame sizes that have one,
+ * keeps the classic radix-2 DIT loop for other frame-sized transforms and
+ * moves whole-recording sizes (>= FFT_SIXSTEP_MIN_N) to the six-step
+ * engine, unless measured wisdom (fft_wisdom.c) names a faster one for the
+ * size; fft_set_engine() forces one engine for all sizes.
+ *
+ * Twiddle tables are built once per (n, direction) and shared by the
+ * engines that index them. A table for size n holds W_n^j for j < n/2,
+ * so a stage of size m reads it with stride n/m.
+ */
+
+static const char* engine_names[FFT_ENGINE_COUNT] = {
+    "auto", "radix2", "radix2-cobra", "stockham", "sixstep", "codelet"
+};
+
+static fft_engine_t current_engine = FFT_ENGINE_AUTO;
+
+#define TWIDDLE_CACHE_SIZES 32
+
+static complex_t* twiddle_cache[2][TWIDDLE_CACHE_SIZES];
+static cq15_t* twiddle_cache_q15[2][TWIDDLE_CACHE_SIZES];
+static pthread_mutex_t twiddle_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void fft_set_engine(fft_engine_t engine) {
+    if (engine >= 0 && engine < FFT_ENGINE_COUNT) {
+        current_engine = engine;
+    }
+}
+
+fft_engine_t fft_get_engine(void) {
+    return current_engine;
+}
+
+/**
+ * @brief Resolve the engine that runs a transform of size n
+ *
+ * @param n Transform size (power of 2)
+ * @param dir Transform direction
+ * @return Concrete engine (never FFT_ENGINE_AUTO)
+ */
+fft_engine_t fft_engine_for(int n, fft_direction dir) {
+    if (current_engine != FFT_ENGINE_AUTO) {
+        return current_engine;
+    }
+    fft_engine_t tuned = fft_wisdom_lookup(n, dir);
+    if (tuned != FFT_ENGINE_AUTO) {
+        return tuned;
+    }
+    if (n >= FFT_SIXSTEP_MIN_N) {
+        return FFT_ENGINE_SIXSTEP;
+    }
+    if (fft_codelet_available(n)) {
+        return FFT_ENGINE_CODELET;
+    }
+    return FFT_ENGINE_RADIX2;
+}
+
+const char* fft_engine_name(fft_engine_t engine) {
+    if (engine < 0 || engine >= FFT_ENGINE_COUNT) return "unknown";
+    return engine_names[engine];
+}
+
+/**
+ * @brief Look up an engine by its name
+ * @return Engine, or -1 if the name is unknown
+ */
+int fft_engine_from_name(const char* name) {
+    for (int i = 0; i < FFT_ENGINE_COUNT; i++) {
+        if (strcmp(name, engine_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Shared table of W_n^j for j < n/2
+ *
+ * @param n Transform size (power of 2)
+ * @param dir Transform direction
+ * @return Table owned by this module, valid until fft_engine_cleanup()
+ */
+const complex_t* fft_twiddles(int n, fft_direction dir) {
+    int log2n = log2_int(n);
+    int d = (dir == FFT_FORWARD) ? 0 : 1;
+
+    complex_t* table = __atomic_load_n(&twiddle_cache[d][log2n], __ATOMIC_ACQUIRE);
+    if (LIKELY(table != NULL)) return table;
+
+    pthread_mutex_lock(&twiddle_lock);
+    table = twiddle_cache[d][log2n];
+    if (table == NULL) {
+        int half = (n > 1) ? n / 2 : 1;
+        table = allocate_complex_array(half);
+        CHECK_NULL(table, "Failed to allocate twiddle table");
+        for (int j = 0; j < half; j++) {
+            table[j] = twiddle_factor(j, n, dir);
+        }
+        __atomic_store_n(&twiddle_cache[d][log2n], table, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&twiddle_lock);
+    return table;
+}
+
+/**
+ * @brief Shared Q15 table of W_n^j for j < n/2 (fixed-point engine)
+ *
+ * @details Rounded from the double table; +1.0 saturates to 32767.
+ *
+ * @param n Transform size (power of 2)
+ * @param dir Transform direction
+ * @return Table owned by this module, valid until fft_engine_cleanup()
+ */
+const cq15_t* fft_twiddles_q15(int n, fft_direction dir) {
+    int log2n = log2_int(n);
+    int d = (dir == FFT_FORWARD) ? 0 : 1;
+
+    cq15_t* table = __atomic_load_n(&twiddle_cache_q15[d][log2n], __ATOMIC_ACQUIRE);
+    if (LIKELY(table != NULL)) return table;
+
+    /* Build the double table first, fft_twiddles() takes the lock itself */
+    const complex_t* source = fft_twiddles(n, dir);
+
+    pthread_mutex_lock(&twiddle_lock);
+    table = twiddle_cache_q15[d][log2n];
+    if (table == NULL) {
+        int half = (n > 1) ? n / 2 : 1;
+        table = (cq15_t*)fft_malloc(half * sizeof(cq15_t));
+        CHECK_NULL(table, "Failed to allocate Q15 twiddle table");
+        for (int j = 0; j < half; j++) {
+            double re = round(creal(source[j]) * 32768.0);
+            double im = round(cimag(source[j]) * 32768.0);
+            table[j].re = (int16_t)fmax(-32768.0, fmin(32767.0, re));
+            table[j].im = (int16_t)fmax(-32768.0, fmin(32767.0, im));
+        }
+        __atomic_store_n(&twiddle_cache_q15[d][log2n], table, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&twiddle_lock);
+    return table;
+}
+
+/**
+ * @brief Release the cached twiddle tables
+ */
+void fft_engine_cleanup(void) {
+    pthread_mutex_lock(&twiddle_lock);
+    for (int d = 0; d < 2; d++) {
+        for (int i = 0; i < TWIDDLE_CACHE_SIZES; i++) {
+            free_complex_array(twiddle_cache[d][i]);
+            twiddle_cache[d][i] = NULL;
+            fft_free(twiddle_cache_q15[d][i]);
+            twiddle_cache_q15[d][i] = NULL;
+        }
+    }
+    pthread_mutex_unlock(&twiddle_lock);
+}
@@ -0,0 +1,168 @@
+#include "fft_common.h"
+#include "fft_algorithms.h"
+
+/**
+ * @file fft_fixed.c
+ * @brief Fixed-point radix-2 DIT FFT with block floating point scaling
+ *
+ * @details
+ * Works directly on 16-bit data: a frame is an array of cq15_t (4 bytes
+ * per sample instead of 16 for complex_t) sharing a single exponent, so
+ * the true value of an element is q * 2^exponent.
+ *
+ * Per-stage scaling: a radix-2 butterfly a +/- w*b can grow a component
+ * by at most 1 + sqrt(2). Before every stage the largest component seen
+ * so far is compared against Q15_STAGE_LIMIT; above it the whole stage
+ * is computed with one or two extra right shifts and the block exponent
+ * grows accordingly. Quiet frames therefore keep all their bits while loud frames
+ * never overflow.
+ *
+ * Products are formed in 32 bits (Q15 x Q15 = Q30) and rounded back to
+ * Q15; a scaled stage shifts the operands before the sum so the Q30
+ * accumulator cannot overflow even from a full-scale block.
+ *
+ * References:
+ * [1] Oppenheim, A. V., & Schafer, R. W. (2009). "Discrete-Time Signal
+ *     Processing", 3rd ed., section 9.7 (finite register length effects)
+ * [2] Welch, P. D. (1969). "A fixed-point fast Fourier transform error
+ *     analysis"
+ */
+
+/* Largest component a stage may start from without an extra shift:
+ * Q15_STAGE_LIMIT * (1 + sqrt(2)) stays below 2^15 */
+#define Q15_STAGE_LIMIT 13500
+
+/* Frames are loaded with this much headroom for the first stage */
+#define Q15_LOAD_LIMIT 0x3000
+
+static inline int abs16(int v) {
+    return v < 0 ? -v : v;
+}
+
+/* Round a Q30 sum back to Q15 (or by any shift >= 1) */
+static inline int32_t round_shift(int32_t v, int shift) {
+    return (v + (1 << (shift - 1))) >> shift;
+}
+
+/**
+ * @brief In-place fixed-point FFT with block floating point
+ *
+ * @param x Input/output array of Q15 samples sharing one exponent
+ * @param n Length of array (must be power of 2)
+ * @param dir Transform direction (FFT_FORWARD or FFT_INVERSE)
+ * @return Exponent to add to the block's exponent: the number of scaled
+ *         stages, minus log2(n) for the inverse transform (1/n scaling)
+ */
+int fft_fixed_q15(cq15_t* x, int n, fft_direction dir) {
+    CHECK_POWER_OF_TWO(n);
+
+    int log2n = log2_int(n);
+    const cq15_t* tw = fft_twiddles_q15(n, dir);
+
+    /* Bit-reversal permutation, tracking the largest component */
+    int peak = 0;
+    for (int i = 0; i < n; i++) {
+        int j = bit_reverse(i, log2n);
+        if (i < j) {
+            cq15_t temp = x[i];
+            x[i] = x[j];
+            x[j] = temp;
+        }
+        int m = abs16(x[i].re) > abs16(x[i].im) ? abs16(x[i].re) : abs16(x[i].im);
+        if (m > peak) peak = m;
+    }
+
+    int exponent = 0;
+    for (int s = 1; s <= log2n; s++) {
+        int m = 1 << s;
+        int half = m >> 1;
+        int stride = n >> s;
+        int scale = 0;
+        while ((peak >> scale) > Q15_STAGE_LIMIT) {
+            scale++;
+        }
+        exponent += scale;
+        peak = 0;
+
+        for (int k = 0; k < n; k += m) {
+            for (int j = 0; j < half; j++) {
+                cq15_t w = tw[j * stride];
+                cq15_t* a = &x[k + j];
+                cq15_t* b = &x[k + j + half];
+
+                /* t = w * b in Q30 (|t| <= sqrt(2) * 2^30), a promoted to
+                 * Q30; a scaled stage shifts both before the sum */
+                int32_t tr = ((int32_t)w.re * b->re - (int32_t)w.im * b->im) >> scale;
+                int32_t ti = ((int32_t)w.re * b->im + (int32_t)w.im * b->re) >> scale;
+                int32_t ar = (int32_t)a->re * (1 << (15 - scale));
+                int32_t ai = (int32_t)a->im * (1 << (15 - scale));
+
+                int32_t r0 = round_shift(ar + tr, 15);
+                int32_t i0 = round_shift(ai + ti, 15);
+                int32_t r1 = round_shift(ar - tr, 15);
+                int32_t i1 = round_shift(ai - ti, 15);
+
+                a->re = (int16_t)r0;
+                a->im = (int16_t)i0;
+                b->re = (int16_t)r1;
+                b->im = (int16_t)i1;
+
+                int m0 = abs16(r0) > abs16(i0) ? abs16(r0) : abs16(i0);
+                int m1 = abs16(r1) > abs16(i1) ? abs16(r1) : abs16(i1);
+                if (m0 > peak) peak = m0;
+                if (m1 > peak) peak = m1;
+            }
+        }
+    }
+
+    if (dir == FFT_INVERSE) {
+        exponent -= log2n;
+    }
+    return exponent;
+}
+
+/**
+ * @brief Window a frame of 16-bit PCM into normalized Q15 samples
+ *
+ * @details
+ * Samples past `count` are zero. The windowed products (Q15 window times
+ * 16-bit sample) are shifted so the largest lands just under
+ * Q15_LOAD_LIMIT, which keeps full precision for quiet frames.
+ *
+ * @param samples PCM samples
+ * @param count Number of PCM samples
+ * @param start First sample of the frame
+ * @param n Frame length
+ * @param window Q15 window of length n, NULL for rectangular
+ * @param out Output array of n Q15 samples
+ * @return Block exponent: sample value = q * 2^exponent
+ */
+int fft_fixed_load_q15(const int16_t* samples, uint32_t count, uint32_t start, int n,
+                       const int16_t* window, cq15_t* out) {
+    /* First pass: largest windowed product (Q15 sample units) */
+    int32_t peak = 0;
+    for (int i = 0; i < n; i++) {
+        uint32_t pos = start + i;
+        if (pos >= count) break;
+        int32_t v = window ? (int32_t)samples[pos] * window[i] : (int32_t)samples[pos] * 32768;
+        if (v < 0) v = -v;
+        if (v > peak) peak = v;
+    }
+
+    int shift = 0;
+    while (shift < 30 && (peak >> shift) >= Q15_LOAD_LIMIT) {
+        shift++;
+    }
+
+    for (int i = 0; i < n; i++) {
+        uint32_t pos = start + i;
+        int32_t v = 0;
+        if (pos < count) {
+            v = window ? (int32_t)samples[pos] * window[i] : (int32_t)samples[pos] * 32768;
+            if (shift > 0) v = round_shift(v, shift);
+        }
+        out[i].re = (int16_t)v;
+        out[i].im = 0;
+    }
+    return shift - 15;
+}
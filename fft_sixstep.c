@@ -0,0 +1,247 @@
+#include <pthread.h>
+#include <unistd.h>
+#include "fft_common.h"
+#include "fft_algorithms.h"
+
+/**
+ * @file fft_sixstep.c
+ * @brief Cache-blocked, multithreaded six-step FFT for very large n
+ *
+ * @details
+ * The iterative radix-2 loop makes log2(n) passes over the whole array,
+ * which for n = 2^20..2^24 means log2(n) trips through main memory.
+ * Bailey's six-step algorithm splits n = n1 * n2 and only touches main
+ * memory a constant number of times:
+ *
+ *   x viewed as an n2 x n1 matrix, x[j1 + n1*j2]
+ *   1. transpose            -> n1 x n2
+ *   2. n1 FFTs of length n2 on the rows
+ *   3. multiply by W_n^(j1*k2) (fused into step 2 while the row is hot)
+ *   4. transpose            -> n2 x n1
+ *   5. n2 FFTs of length n1 on the rows
+ *   6. transpose            -> X[k2 + n2*k1]
+ *
+ * With n1, n2 ~ sqrt(n) every row FFT (<= 4096 points, 64 KB) fits in
+ * L2 cache. Transposes are done in tiles, and both transposes and row
+ * passes are split across threads.
+ *
+ * References:
+ * [1] Bailey, D. H. (1990). "FFTs in external or hierarchical memory"
+ */
+
+#define SIXSTEP_TILE 32
+
+static int sixstep_threads = 0;  /* 0 = number of online CPUs */
+
+/**
+ * @brief Set the number of worker threads (0 = one per online CPU)
+ */
+void fft_set_threads(int threads) {
+    sixstep_threads = (threads < 0) ? 0 : threads;
+}
+
+int fft_get_threads(void) {
+    if (sixstep_threads > 0) return sixstep_threads;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (int)cpus : 1;
+}
+
+/* Work description shared by all worker threads of one pass */
+typedef struct {
+    void (*fn)(void* ctx, int begin, int end);
+    void* ctx;
+    int begin;
+    int end;
+} sixstep_job_t;
+
+static void* sixstep_worker(void* arg) {
+    sixstep_job_t* job = (sixstep_job_t*)arg;
+    job->fn(job->ctx, job->begin, job->end);
+    return NULL;
+}
+
+/**
+ * @brief Run fn over [0, count) split into contiguous ranges, one per thread
+ */
+static void parallel_for(int count, int threads,
+                         void (*fn)(void* ctx, int begin, int end), void* ctx) {
+    if (threads > count) threads = count;
+    if (threads <= 1) {
+        fn(ctx, 0, count);
+        return;
+    }
+
+    pthread_t tids[threads];
+    sixstep_job_t jobs[threads];
+    int created[threads];
+
+    for (int t = 0; t < threads; t++) {
+        jobs[t].fn = fn;
+        jobs[t].ctx = ctx;
+        jobs[t].begin = (int)((long long)count * t / threads);
+        jobs[t].end = (int)((long long)count * (t + 1) / threads);
+        created[t] = 0;
+        if (t == 0) continue;  /* first range runs on the calling thread */
+        created[t] = (pthread_create(&tids[t], NULL, sixstep_worker, &jobs[t]) == 0);
+    }
+
+    fn(ctx, jobs[0].begin, jobs[0].end);
+
+    for (int t = 1; t < threads; t++) {
+        if (created[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            /* Could not start a thread, do its share here */
+            fn(ctx, jobs[t].begin, jobs[t].end);
+        }
+    }
+}
+
+/* Tiled transpose of a rows x cols matrix src into dst (cols x rows) */
+typedef struct {
+    const complex_t* src;
+    complex_t* dst;
+    int rows;
+    int cols;
+} transpose_ctx_t;
+
+static void transpose_tiles(void* arg, int begin, int end) {
+    transpose_ctx_t* t = (transpose_ctx_t*)arg;
+
+    /* [begin, end) are tile rows of the source */
+    for (int tr = begin; tr < end; tr++) {
+        int r0 = tr * SIXSTEP_TILE;
+        int r1 = r0 + SIXSTEP_TILE;
+        if (r1 > t->rows) r1 = t->rows;
+
+        for (int c0 = 0; c0 < t->cols; c0 += SIXSTEP_TILE) {
+            int c1 = c0 + SIXSTEP_TILE;
+            if (c1 > t->cols) c1 = t->cols;
+
+            for (int r = r0; r < r1; r++) {
+                const complex_t* src = t->src + (size_t)r * t->cols;
+                for (int c = c0; c < c1; c++) {
+                    t->dst[(size_t)c * t->rows + r] = src[c];
+                }
+            }
+        }
+    }
+}
+
+static void transpose(const complex_t* src, complex_t* dst, int rows, int cols, int threads) {
+    transpose_ctx_t ctx = {src, dst, rows, cols};
+    int tile_rows = (rows + SIXSTEP_TILE - 1) / SIXSTEP_TILE;
+    parallel_for(tile_rows, threads, transpose_tiles, &ctx);
+}
+
+/* Row FFTs, optionally followed by the W_n^(row * k) twiddle multiply */
+typedef struct {
+    complex_t* data;
+    int rows;
+    int len;
+    fft_direction dir;
+    const complex_t* tw_lo;  /* W_n^i for i < 2^lo_bits, NULL = no twiddle */
+    const complex_t* tw_hi;  /* W_n^(i << lo_bits) */
+    int lo_bits;
+} rows_ctx_t;
+
+static void fft_rows(void* arg, int begin, int end) {
+    rows_ctx_t* r = (rows_ctx_t*)arg;
+    complex_t* scratch = allocate_complex_array(r->len);
+    CHECK_NULL(scratch, "Failed to allocate six-step scratch row");
+    unsigned int lo_mask = (1u << r->lo_bits) - 1;
+
+    for (int row = begin; row < end; row++) {
+        complex_t* x = r->data + (size_t)row * r->len;
+
+        /* Inverse row transforms scale by 1/n1 and 1/n2, i.e. 1/n overall */
+        stockham_fft_buffer(x, scratch, r->len, r->dir);
+
+        if (r->tw_lo != NULL) {
+            for (int k = 1; k < r->len; k++) {
+                unsigned int e = (unsigned int)row * (unsigned int)k;
+                x[k] *= r->tw_lo[e & lo_mask] * r->tw_hi[e >> r->lo_bits];
+            }
+        }
+    }
+
+    free_complex_array(scratch);
+}
+
+/* Final copy back into the caller's array */
+typedef struct {
+    const complex_t* src;
+    complex_t* dst;
+    int chunk;
+} copy_ctx_t;
+
+static void copy_chunks(void* arg, int begin, int end) {
+    copy_ctx_t* c = (copy_ctx_t*)arg;
+    size_t start = (size_t)begin * c->chunk;
+    memcpy(c->dst + start, c->src + start, (size_t)(end - begin) * c->chunk * sizeof(complex_t));
+}
+
+/**
+ * @brief Six-step FFT with a caller-provided scratch buffer
+ *
+ * @param x Input/output array of complex numbers
+ * @param y Scratch array of the same length
+ * @param n Length of array (must be power of 2)
+ * @param dir Transform direction (FFT_FORWARD or FFT_INVERSE)
+ */
+void fft_sixstep_buffer(complex_t* x, complex_t* y, int n, fft_direction dir) {
+    CHECK_POWER_OF_TWO(n);
+
+    int log2n = log2_int(n);
+    if (log2n < 4) {
+        stockham_fft_buffer(x, y, n, dir);
+        return;
+    }
+
+    int n1 = 1 << (log2n / 2);   /* columns of the input view */
+    int n2 = n / n1;             /* rows of the input view, n2 >= n1 */
+    int threads = fft_get_threads();
+
+    /* Split twiddle table: W_n^e = tw_lo[e mod 2^lo] * tw_hi[e >> lo] */
+    int lo_bits = (log2n + 1) / 2;
+    int lo_size = 1 << lo_bits;
+    int hi_size = n >> lo_bits;
+    complex_t* tw_lo = allocate_complex_array(lo_size);
+    complex_t* tw_hi = allocate_complex_array(hi_size);
+    CHECK_NULL(tw_lo, "Failed to allocate six-step twiddles");
+    CHECK_NULL(tw_hi, "Failed to allocate six-step twiddles");
+    for (int i = 0; i < lo_size; i++) tw_lo[i] = twiddle_factor(i, n, dir);
+    for (int i = 0; i < hi_size; i++) tw_hi[i] = twiddle_factor(i << lo_bits, n, dir);
+
+    /* Steps 1-3: transpose, n1 row FFTs of length n2 with twiddles */
+    transpose(x, y, n2, n1, threads);
+    rows_ctx_t pass1 = {y, n1, n2, dir, tw_lo, tw_hi, lo_bits};
+    parallel_for(n1, threads, fft_rows, &pass1);
+
+    /* Steps 4-5: transpose, n2 row FFTs of length n1 */
+    transpose(y, x, n1, n2, threads);
+    rows_ctx_t pass2 = {x, n2, n1, dir, NULL, NULL, 0};
+    parallel_for(n2, threads, fft_rows, &pass2);
+
+    /* Step 6: transpose into output order, then copy back */
+    transpose(x, y, n2, n1, threads);
+    copy_ctx_t copy = {y, x, n1};
+    parallel_for(n2, threads, copy_chunks, &copy);
+
+    free_complex_array(tw_lo);
+    free_complex_array(tw_hi);
+}
+
+/**
+ * @brief Six-step FFT, allocating its own scratch buffer
+ *
+ * @param x Input/output array of complex numbers
+ * @param n Length of array (must be power of 2)
+ * @param dir Transform direction (FFT_FORWARD or FFT_INVERSE)
+ */
+void fft_sixstep(complex_t* x, int n, fft_direction dir) {
+    complex_t* y = (complex_t*)fft_malloc((size_t)n * sizeof(complex_t));
+    CHECK_NULL(y, "Failed to allocate six-step scratch buffer");
+    fft_sixstep_buffer(x, y, n, dir);
+    fft_free(y);
+}
@@ -0,0 +1,243 @@
+#include <stdbool.h>
+#include "fft_common.h"
+#include "fft_algorithms.h"
+#include "frame_kernels.h"
+#include "wavformat.h"
+
+/**
+ * @file fft_wisdom.c
+ * @brief Measured engine choice per transform size, persisted as "wisdom"
+ *
+ * @details
+ * Which engine is fastest for a given size depends on the machine (cache
+ * sizes, ISA, core count), so instead of fixed thresholds the candidates
+ * can be timed once and the winners stored in a small text file:
+ *
+ *   pitch-fft-wisdom 1
+ *   isa avx2
+ *   f64 forward 4096 codelet 18230
+ *
+ * one line per (precision, direction, size) with the winning engine and
+ * its time per transform in ns. fft_engine_for() consults the table
+ * before its built-in heuristics, so once the file is loaded choosing an
+ * engine is a table lookup.
+ *
+ * Only double precision has several engines; the Q15 path has a single
+ * implementation and nothing to tune, so only "f64" lines are written.
+ * Wisdom measured on a different ISA is ignored when loading.
+ */
+
+#define WISDOM_MAGIC "pitch-fft-wisdom"
+#define WISDOM_VERSION 1
+#define WISDOM_SIZES 32
+
+#define AUTOTUNE_TRIALS 5
+#define AUTOTUNE_POINTS (1 << 18)      /* points transformed per trial */
+#define AUTOTUNE_SIXSTEP_MIN_N (1 << 14)
+
+/* Tuned engine per direction and log2(n), FFT_ENGINE_AUTO = not tuned */
+static fft_engine_t tuned_engine[2][WISDOM_SIZES];
+static double tuned_ns[2][WISDOM_SIZES];
+
+static const char* direction_names[2] = { "forward", "inverse" };
+
+/**
+ * @brief Tuned engine for a transform, FFT_ENGINE_AUTO if none is known
+ */
+fft_engine_t fft_wisdom_lookup(int n, fft_direction dir) {
+    int log2n = log2_int(n);
+    if (log2n >= WISDOM_SIZES) return FFT_ENGINE_AUTO;
+    return tuned_engine[dir == FFT_FORWARD ? 0 : 1][log2n];
+}
+
+/**
+ * @brief Drop all tuned entries (back to the built-in heuristics)
+ */
+void fft_wisdom_forget(void) {
+    for (int d = 0; d < 2; d++) {
+        for (int i = 0; i < WISDOM_SIZES; i++) {
+            tuned_engine[d][i] = FFT_ENGINE_AUTO;
+            tuned_ns[d][i] = 0;
+        }
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Best time per transform over several trials, in ns */
+static double time_engine(fft_engine_t engine, complex_t* x, const complex_t* input,
+                          int n, fft_direction dir) {
+    int reps = AUTOTUNE_POINTS / n;
+    if (reps < 1) reps = 1;
+
+    fft_set_engine(engine);
+    memcpy(x, input, n * sizeof(complex_t));
+    radix2_dit_fft(x, n, dir);      /* warm up twiddles and caches */
+
+    double best = INFINITY;
+    for (int t = 0; t < AUTOTUNE_TRIALS; t++) {
+        double start = now_ns();
+        for (int r = 0; r < reps; r++) {
+            memcpy(x, input, n * sizeof(complex_t));
+            radix2_dit_fft(x, n, dir);
+        }
+        double elapsed = (now_ns() - start) / reps;
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+/**
+ * @brief Time every engine for sizes min_n..max_n in both directions
+ *
+ * @details The fastest engine per (n, direction) replaces any earlier
+ * entry. Runs single-threaded with respect to other transforms: the
+ * engine override is switched while timing and restored afterwards.
+ *
+ * @param min_n Smallest size (power of 2)
+ * @param max_n Largest size (power of 2)
+ * @param report Progress table, or NULL
+ */
+void fft_autotune(int min_n, int max_n, FILE* report) {
+    fft_engine_t saved = fft_get_engine();
+    complex_t* input = allocate_complex_array(max_n);
+    complex_t* x = allocate_complex_array(max_n);
+    CHECK_NULL(input, "Failed to allocate autotune buffers");
+    CHECK_NULL(x, "Failed to allocate autotune buffers");
+
+    for (int i = 0; i < max_n; i++) {
+        input[i] = CMPLX((double)rand() / RAND_MAX - 0.5, (double)rand() / RAND_MAX - 0.5);
+    }
+
+    if (report) {
+        fprintf(report, "FFT autotune (%s, %d threads)\n", frame_kernels_isa(), fft_get_threads());
+        fprintf(report, "%8s %-8s %-13s %10s %10s\n", "n", "dir", "engine", "ns", "default ns");
+    }
+
+    for (int n = min_n; n <= max_n; n *= 2) {
+        int log2n = log2_int(n);
+        for (int d = 0; d < 2; d++) {
+            fft_direction dir = d ? FFT_INVERSE : FFT_FORWARD;
+            fft_engine_t best = FFT_ENGINE_AUTO;
+            double best_ns = INFINITY;
+            double engine_ns[FFT_ENGINE_COUNT] = {0};
+
+            for (int e = FFT_ENGINE_RADIX2; e < FFT_ENGINE_COUNT; e++) {
+                /* Codelet falls back to radix-2 without a kernel; six-step
+                   only pays off once rows stop fitting in cache */
+                if (e == FFT_ENGINE_CODELET && !fft_codelet_available(n)) continue;
+                if (e == FFT_ENGINE_SIXSTEP && n < AUTOTUNE_SIXSTEP_MIN_N) continue;
+
+                engine_ns[e] = time_engine(e, x, input, n, dir);
+                if (engine_ns[e] < best_ns) {
+                    best_ns = engine_ns[e];
+                    best = e;
+                }
+            }
+
+            /* What the untuned heuristics would have picked, for comparison */
+            fft_set_engine(FFT_ENGINE_AUTO);
+            tuned_engine[d][log2n] = FFT_ENGINE_AUTO;
+            fft_engine_t fallback = fft_engine_for(n, dir);
+
+            tuned_engine[d][log2n] = best;
+            tuned_ns[d][log2n] = best_ns;
+            if (report) {
+                fprintf(report, "%8d %-8s %-13s %10.0f %10.0f\n", n, direction_names[d],
+                        fft_engine_name(best), best_ns, engine_ns[fallback]);
+            }
+        }
+    }
+
+    fft_set_engine(saved);
+    free_complex_array(x);
+    free_complex_array(input);
+}
+
+/**
+ * @brief Write the tuned entries to a wisdom file
+ * @return false if the file could not be written
+ */
+bool fft_wisdom_save(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        PRINT_ERROR("%s: Failed to open wisdom file for writing", path);
+        return false;
+    }
+    fprintf(file, "%s %d\n", WISDOM_MAGIC, WISDOM_VERSION);
+    fprintf(file, "isa %s\n", frame_kernels_isa());
+    for (int d = 0; d < 2; d++) {
+        for (int i = 0; i < WISDOM_SIZES; i++) {
+            if (tuned_engine[d][i] == FFT_ENGINE_AUTO) continue;
+            fprintf(file, "f64 %s %d %s %.0f\n", direction_names[d], 1 << i,
+                    fft_engine_name(tuned_engine[d][i]), tuned_ns[d][i]);
+        }
+    }
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        PRINT_ERROR("%s: Failed to write wisdom file", path);
+    }
+    return ok;
+}
+
+/**
+ * @brief Load tuned entries from a wisdom file
+ *
+ * @details Entries from the file replace the current ones for the same
+ * (n, direction). Unknown precisions or engines are skipped so older
+ * binaries can read newer files.
+ *
+ * @return false if the file is missing, malformed or from another ISA
+ */
+bool fft_wisdom_load(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+
+    char line[256];
+    int version = 0;
+    char magic[32] = "";
+    if (fgets(line, sizeof(line), file) == NULL ||
+        sscanf(line, "%31s %d", magic, &version) != 2 ||
+        strcmp(magic, WISDOM_MAGIC) != 0 || version != WISDOM_VERSION) {
+        PRINT_ERROR("%s: not a version %d wisdom file", path, WISDOM_VERSION);
+        fclose(file);
+        return false;
+    }
+
+    char isa[32] = "";
+    if (fgets(line, sizeof(line), file) == NULL ||
+        sscanf(line, "isa %31s", isa) != 1 || strcmp(isa, frame_kernels_isa()) != 0) {
+        PRINT_ERROR("%s: wisdom was measured on another ISA (%s), ignoring it", path, isa);
+        fclose(file);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char precision[16], direction[16], engine_name[32];
+        int n;
+        double ns;
+        if (sscanf(line, "%15s %15s %d %31s %lf", precision, direction, &n, engine_name, &ns) != 5) {
+            continue;
+        }
+        int engine = fft_engine_from_name(engine_name);
+        if (strcmp(precision, "f64") != 0 || engine <= FFT_ENGINE_AUTO ||
+            !is_power_of_two(n) || log2_int(n) >= WISDOM_SIZES) {
+            continue;
+        }
+        int d = (strcmp(direction, direction_names[1]) == 0) ? 1 : 0;
+        if (d == 0 && strcmp(direction, direction_names[0]) != 0) {
+            continue;
+        }
+        tuned_engine[d][log2_int(n)] = engine;
+        tuned_ns[d][log2_int(n)] = ns;
+    }
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,287 @@
+#include "frame_kernels.h"
+#include "audio_spectrum.h"
+
+// Complex arrays are read as interleaved doubles (re, im), which C
+// guarantees for double complex. The loops are written so the compiler
+// can vectorize them without -ffast-math: reductions keep one partial
+// sum per lane and conditionals are turned into flag arithmetic.
+
+#define ENERGY_LANES 8
+
+// Sum of x^2 over the frame, matching compute_energy(): the real part of
+// the complex square, re^2 - im^2
+FFT_TARGET_CLONES
+double frame_energy(const complex_t* x, int n) {
+    const double* d = (const double*)x;
+    double acc[ENERGY_LANES] = {0};
+    int m = 2 * n;
+    int i = 0;
+
+    for (; i + ENERGY_LANES <= m; i += ENERGY_LANES) {
+        for (int j = 0; j < ENERGY_LANES; j++) {
+            acc[j] += d[i + j] * d[i + j];
+        }
+    }
+    for (; i < m; i++) {
+        acc[i % ENERGY_LANES] += d[i] * d[i];
+    }
+
+    // Even lanes hold real parts, odd lanes imaginary parts
+    double re = 0, im = 0;
+    for (int j = 0; j < ENERGY_LANES; j += 2) {
+        re += acc[j];
+        im += acc[j + 1];
+    }
+    return re - im;
+}
+
+// |x| per bin. Plain sqrt instead of cabs (no overflow-safe hypot needed
+// for audio magnitudes), built with -fno-math-errno so it vectorizes
+FFT_TARGET_CLONES
+void frame_magnitude(const complex_t* x, int n, double* magnitude) {
+    const double* d = (const double*)x;
+    for (int i = 0; i < n; i++) {
+        double re = d[2 * i];
+        double im = d[2 * i + 1];
+        magnitude[i] = sqrt(re * re + im * im);
+    }
+}
+
+// |x|^2 / n per bin, as compute_power_spectrum()
+FFT_TARGET_CLONES
+void frame_power(const complex_t* x, int n, double* power) {
+    const double* d = (const double*)x;
+    double scale = 1.0 / n;
+    for (int i = 0; i < n; i++) {
+        double re = d[2 * i];
+        double im = d[2 * i + 1];
+        power[i] = (re * re + im * im) * scale;
+    }
+}
+
+// Multiply by a precomputed window (see window_table())
+FFT_TARGET_CLONES
+void frame_window(complex_t* x, const double* window, int n) {
+    double* d = (double*)x;
+    for (int i = 0; i < n; i++) {
+        d[2 * i] *= window[i];
+        d[2 * i + 1] *= window[i];
+    }
+}
+
+#define PEAK_BLOCK 256
+
+// Bins in [lo, hi) that are strict local maxima above threshold, in
+// ascending order, at most max_bins of them. Needs 1 <= lo and hi less
+// than the array length. Flags are computed a block at a time (vector
+// compares), then the mostly-zero flag bytes are skipped eight at a time.
+FFT_TARGET_CLONES
+int frame_local_maxima(const double* magnitude, int lo, int hi, double threshold,
+                       int* bins, int max_bins) {
+    unsigned char flags[PEAK_BLOCK + 8];
+    int count = 0;
+
+    for (int base = lo; base < hi && count < max_bins; base += PEAK_BLOCK) {
+        int len = hi - base;
+        if (len > PEAK_BLOCK) len = PEAK_BLOCK;
+
+        const double* m = magnitude + base;
+        for (int j = 0; j < len; j++) {
+            flags[j] = (m[j] > m[j - 1]) & (m[j] > m[j + 1]) & (m[j] > threshold);
+        }
+        memset(flags + len, 0, 8);
+
+        for (int j = 0; j < len && count < max_bins; j += 8) {
+            uint64_t word;
+            memcpy(&word, flags + j, 8);
+            if (word == 0) continue;
+            for (int k = j; k < j + 8 && k < len && count < max_bins; k++) {
+                if (flags[k]) bins[count++] = base + k;
+            }
+        }
+    }
+    return count;
+}
+
+// Harmonic product over `bins` magnitudes (n/2 + 1 for an n-point FFT):
+// hps[i] = mag[i] * mag[2i] * ... * mag[harmonics*i], each factor only
+// while its index is in range, as in detect_pitch_hps()
+FFT_TARGET_CLONES
+void frame_hps_product(const double* magnitude, int bins, int harmonics, double* hps) {
+    for (int i = 0; i < bins; i++) {
+        hps[i] = magnitude[i];
+    }
+    for (int h = 2; h <= harmonics; h++) {
+        int limit = (bins - 1) / h;
+        for (int i = 0; i <= limit; i++) {
+            hps[i] *= magnitude[i * h];
+        }
+    }
+}
+
+// Sum of |a[i] - b[i]| over int16 samples, the AMDF inner loop. The
+// differences are widened to 32 bits; for n up to 65536 the 32-bit sum
+// cannot overflow.
+FFT_TARGET_CLONES
+uint32_t frame_abs_diff_i16(const int16_t* a, const int16_t* b, int n) {
+    uint32_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t d = (int32_t)a[i] - (int32_t)b[i];
+        sum += (uint32_t)(d < 0 ? -d : d);
+    }
+    return sum;
+}
+
+// ISA the FFT_TARGET_CLONES resolvers pick on this machine
+const char* frame_kernels_isa(void) {
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return "avx2";
+#endif
+    return "generic";
+}
+
+// Scalar references, written like the loops the kernels replace
+static double reference_energy(complex_t* signal, int n) {
+    double energy = 0;
+    for (int i = 0; i < n; i++) {
+        energy += pow(signal[i], 2.0);
+    }
+    return energy;
+}
+
+static int reference_local_maxima(const double* magnitude, int lo, int hi, double threshold,
+                                  int* bins, int max_bins) {
+    int count = 0;
+    for (int i = lo; i < hi && count < max_bins; i++) {
+        if (magnitude[i] > magnitude[i-1] &&
+            magnitude[i] > magnitude[i+1] &&
+            magnitude[i] > threshold) {
+            bins[count++] = i;
+        }
+    }
+    return count;
+}
+
+static double max_relative_error(const double* a, const double* b, int n) {
+    double worst = 0;
+    for (int i = 0; i < n; i++) {
+        double scale = fmax(fabs(a[i]), fabs(b[i]));
+        if (scale > 0) worst = fmax(worst, fabs(a[i] - b[i]) / scale);
+    }
+    return worst;
+}
+
+static bool check(FILE* report, const char* name, double error, double tolerance) {
+    bool ok = error <= tolerance;
+    fprintf(report, "  %-16s max rel. error %.2e  %s\n", name, error, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+#define SELFCHECK_N 4096
+#define SELFCHECK_TOLERANCE 1e-12
+
+// Run every kernel against its scalar reference on a synthetic frame
+bool frame_kernels_selfcheck(FILE* report) {
+    int n = SELFCHECK_N;
+    int bins = n / 2 + 1;
+    complex_t* signal = allocate_complex_array(n);
+    complex_t* windowed = allocate_complex_array(n);
+    double* expected = fft_malloc(n * sizeof(double));
+    double* actual = fft_malloc(n * sizeof(double));
+    int* expected_bins = fft_malloc(n * sizeof(int));
+    int* actual_bins = fft_malloc(n * sizeof(int));
+    CHECK_NULL(signal, "Failed to allocate selfcheck buffers");
+    CHECK_NULL(windowed, "Failed to allocate selfcheck buffers");
+    CHECK_NULL(expected, "Failed to allocate selfcheck buffers");
+    CHECK_NULL(actual, "Failed to allocate selfcheck buffers");
+    CHECK_NULL(expected_bins, "Failed to allocate selfcheck buffers");
+    CHECK_NULL(actual_bins, "Failed to allocate selfcheck buffers");
+
+    double harmonic_amps[] = {1.0, 0.5, 0.3, 0.2, 0.1};
+    for (int i = 0; i < n; i++) {
+        double t = i / 44100.0;
+        double v = 0;
+        for (int h = 0; h < 5; h++) {
+            v += harmonic_amps[h] * sin(TWO_PI * 196.0 * (h + 1) * t);
+        }
+        signal[i] = 8000.0 * v + 50.0 * ((double)rand() / RAND_MAX - 0.5);
+    }
+
+    fprintf(report, "Frame kernels (%s), n = %d\n", frame_kernels_isa(), n);
+    bool ok = true;
+
+    // Energy
+    double e_ref = reference_energy(signal, n);
+    double e_vec = frame_energy(signal, n);
+    ok &= check(report, "energy", fabs(e_ref - e_vec) / fabs(e_ref), SELFCHECK_TOLERANCE);
+
+    // Windows
+    double worst = 0;
+    for (int w = WINDOW_HANN; w < WINDOW_COUNT; w++) {
+        double* table = window_table(n, w);
+        memcpy(windowed, signal, n * sizeof(complex_t));
+        apply_window(windowed, n, w);
+        for (int i = 0; i < n; i++) expected[i] = creal(windowed[i]);
+        memcpy(windowed, signal, n * sizeof(complex_t));
+        frame_window(windowed, table, n);
+        for (int i = 0; i < n; i++) actual[i] = creal(windowed[i]);
+        worst = fmax(worst, max_relative_error(expected, actual, n));
+        fft_free(table);
+    }
+    ok &= check(report, "window", worst, SELFCHECK_TOLERANCE);
+
+    // Spectrum passes on the transformed frame
+    memcpy(windowed, signal, n * sizeof(complex_t));
+    apply_window_hann(windowed, n);
+    radix2_dit_fft(windowed, n, FFT_FORWARD);
+
+    double* ref_mag = compute_magnitude(windowed, n);
+    frame_magnitude(windowed, n, actual);
+    ok &= check(report, "magnitude", max_relative_error(ref_mag, actual, n), SELFCHECK_TOLERANCE);
+
+    double* ref_power = compute_power_spectrum(windowed, n);
+    frame_power(windowed, n, actual);
+    ok &= check(report, "power", max_relative_error(ref_power, actual, n), SELFCHECK_TOLERANCE);
+    fft_free(ref_power);
+
+    int lo = 1, hi = n / 2 - 1;
+    int expected_count = reference_local_maxima(ref_mag, lo, hi, 0.1, expected_bins, n);
+    int actual_count = frame_local_maxima(ref_mag, lo, hi, 0.1, actual_bins, n);
+    bool same = (expected_count == actual_count) &&
+                memcmp(expected_bins, actual_bins, expected_count * sizeof(int)) == 0;
+    fprintf(report, "  %-16s %d peaks  %s\n", "local maxima", actual_count, same ? "ok" : "FAILED");
+    ok &= same;
+
+    for (int i = 0; i < bins; i++) expected[i] = ref_mag[i];
+    for (int h = 2; h <= 5; h++) {
+        for (int i = 0; i <= n / (2 * h); i++) {
+            expected[i] *= ref_mag[i * h];
+        }
+    }
+    frame_hps_product(ref_mag, bins, 5, actual);
+    ok &= check(report, "HPS product", max_relative_error(expected, actual, bins), SELFCHECK_TOLERANCE);
+
+    // Absolute differences on the frame as 16-bit PCM, at a few lags
+    int16_t* pcm = (int16_t*)expected_bins;
+    for (int i = 0; i < n; i++) pcm[i] = (int16_t)creal(signal[i]);
+    same = true;
+    for (int lag = 1; lag < n / 2; lag += 97) {
+        uint32_t ref = 0;
+        for (int i = 0; i < n / 2; i++) ref += abs(pcm[i] - pcm[i + lag]);
+        same &= (ref == frame_abs_diff_i16(pcm, pcm + lag, n / 2));
+    }
+    fprintf(report, "  %-16s %s\n", "abs diff i16", same ? "ok" : "FAILED");
+    ok &= same;
+
+    fft_free(ref_mag);
+    fft_free(actual_bins);
+    fft_free(expected_bins);
+    fft_free(actual);
+    fft_free(expected);
+    free_complex_array(windowed);
+    free_complex_array(signal);
+
+    fprintf(report, "%s\n", ok ? "All kernels match" : "Kernel mismatch");
+    return ok;
+}
@@ -0,0 +1,25 @@
+#ifndef FRAME_KERNELS_H
+#define FRAME_KERNELS_H
+
+#include <stdbool.h>
+#include "fft_common.h"
+
+// Vectorized per-frame passes around the FFT. Each kernel is compiled for
+// several ISAs (FFT_TARGET_CLONES) and the best one is picked at load
+// time. The scalar functions they replace (compute_magnitude, the
+// apply_window_* loops, ...) stay as the reference; frame_kernels_selfcheck
+// compares the two.
+
+double frame_energy(const complex_t* x, int n);
+void frame_magnitude(const complex_t* x, int n, double* magnitude);
+void frame_power(const complex_t* x, int n, double* power);
+void frame_window(complex_t* x, const double* window, int n);
+int frame_local_maxima(const double* magnitude, int lo, int hi, double threshold,
+                       int* bins, int max_bins);
+void frame_hps_product(const double* magnitude, int bins, int harmonics, double* hps);
+uint32_t frame_abs_diff_i16(const int16_t* a, const int16_t* b, int n);
+
+const char* frame_kernels_isa(void);
+bool frame_kernels_selfcheck(FILE* report);
+
+#endif
@@ -1,6 +1,18 @@
 #include "wavformat.h"
 #include "pitch_detection.h"
 #include "audio_spectrum.h"
+#include "result_sink.h"
+#include "spectrogram.h"
+#include "multires.h"
+#include "frame_kernels.h"
+#include "stats.h"
+#include "result_cache.h"
+#include "synth.h"
+#include "corpus.h"
+#include "note_bank.h"
+#include "pitch_tracker.h"
+#include "spectral_peaks.h"
+#include "prefilter.h"
 
 double fundamental_freq[] = {65.41,69.30,73.42,77.78,
                             82.41,87.31,92.50,98.00,
@@ -8,14 +20,6 @@ double fundamental_freq[] = {65.41,69.30,73.42,77.78,
 
 int freq_number = 49;
 
-double compute_energy(complex_t* signal, int n){
-    double energy = 0;
-    for(int i=0;i<n;i++){
-        energy +=pow(signal[i],2.0);
-    }
-    return energy;
-}
-
 bool check_new_pitch(double *pitches, double *curr_pitches, int idx){
     if(pitches[idx]!=curr_pitches[idx]){
         return 1;
@@ -23,11 +27,47 @@ bool check_new_pitch(double *pitches, double *curr_pitches, int idx){
     return 0;
 
 }
-const char* methods[] = {"Maximum Peak", "HPS", "Autocorrelation"};
+#define NUM_METHODS 11
+#define METHOD_HPS 1
+#define METHOD_AUTOCORR 2
+#define METHOD_CASCADE 3
+#define METHOD_ZOOM 4
+#define METHOD_PHASE_VOCODER 5
+#define METHOD_MULTIRES 6
+#define METHOD_FIXED 7
+#define METHOD_CEPSTRUM 8
+#define METHOD_HARMONIC 9
+#define METHOD_AMDF 10
+
+// Harmonics matched against the sparse peak list by Harmonic Peaks
+#define HARMONIC_PEAKS_HARMONICS 8
+
+// Frames projected per note bank call in the semitone (Maximum Peak) path
+#define NOTE_BANK_BLOCK 64
+
+// Sizes timed by --autotune: analysis frames up to whole recordings
+#define AUTOTUNE_MIN_N 256
+#define AUTOTUNE_MAX_N (1 << 20)
+
+// Fixed analysis parameters that are part of every result cache key
+#define CACHE_HPS_HARMONICS 5
+const char* methods[NUM_METHODS] = {"Maximum Peak", "HPS", "Autocorrelation", "Cascade", "Zoom Peak",
+                                    "Phase Vocoder", "Multi-Resolution", "Fixed-Point Peak", "Cepstrum",
+                                    "Harmonic Peaks", "AMDF"};
+// Index of a method name in methods[], -1 if there is no such method
+int method_index(const char* method){
+    for(int i = 0; i < NUM_METHODS; i++){
+        if(strcmp(method,methods[i]) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+const char* cascade_stage_names[CASCADE_STAGE_COUNT] = {"silent", "cheap", "peak", "HPS", "autocorrelation"};
 
 void display_current_pitch_wav(double energy,double *pitches, double confidence, int num_frame, const char * method){
     int idx = -1;
-    for(int i; i< 3;i++){
+    for(int i = 0; i< NUM_METHODS;i++){
         if(strcmp(method,methods[i]) == 0){
             idx = i;
             printf("Frame:%d\n",num_frame);
@@ -68,32 +108,96 @@ void display_spectrum_ascii_v2(double* magnitude, int k, double *fundamentals) {
     }
 }
 
-void analyze_wav_file(sound_t sound, int n, double sample_rate, const char* method){
-    static uint32_t sound_position = 0; //Variable to iterate over the samples
-    double *curr_pitches = calloc(3,sizeof(double)); // current pitches (estimated by each method)
+// With --track, emit_pitch() feeds the tracker and the frames it decides
+// reach the sink through emit_tracked()
+static struct {
+    pitch_tracker_t* tracker;
+    result_sink_t* sink;
+    int method;
+} tracking = {NULL, NULL, 0};
+
+static void write_pitch(result_sink_t* sink, int num_frame, double timestamp,
+                        int method, double frequency, double confidence){
+    STATS_BEGIN(span);
+    pitch_record_t record;
+    record.frame = num_frame;
+    record.timestamp = timestamp;
+    record.method = method;
+    record.frequency = frequency;
+    record.cents = 0;
+    record.note = (frequency > 0) ? frequency_to_note(frequency, &record.cents) : -1;
+    record.confidence = confidence;
+    result_sink_write(sink, &record);
+    STATS_END(STATS_OUTPUT, span);
+}
+
+static void emit_tracked(const pitch_track_point_t* point, void* ctx){
+    (void)ctx;
+    write_pitch(tracking.sink, point->frame, point->timestamp, tracking.method,
+                point->frequency, point->confidence);
+}
+
+// Send one analyzed frame to the result sink
+void emit_pitch(result_sink_t* sink, int num_frame, double timestamp,
+                int method, double frequency, double confidence){
+    if(tracking.tracker != NULL){
+        pitch_candidate_t candidate = {frequency, confidence};
+        tracking.sink = sink;
+        tracking.method = method;
+        pitch_tracker_push(tracking.tracker, num_frame, timestamp, &candidate, 1);
+        return;
+    }
+    write_pitch(sink, num_frame, timestamp, method, frequency, confidence);
+}
+
+void analyze_wav_file(sound_t sound, int n, int hop, double sample_rate, const char* method, result_sink_t* sink){
+    uint32_t frame_start = 0; //First sample of the current frame, advances by hop
+    double *curr_pitches = fft_calloc(3,sizeof(double)); // current pitches (estimated by each method)
+    double *pitches = fft_calloc(3,sizeof(double));      // pitches of the current frame
     double curr_energy =0.0;    //Energy of last analyzed signal frame
     int num_frame = 0;
-    int idx = 0;
+    int idx = method_index(method);
+    cascade_config_t cascade = cascade_default_config();
+    int stage_counts[CASCADE_STAGE_COUNT] = {0};
+    phase_vocoder_t* pv = NULL;
+    peak_engine_t* peak_engine = NULL;
+    peak_t* peaks = NULL;
+    double* window = window_table(n, WINDOW_HANN);
+    // Frame buffers are reused, the loop itself does not allocate
+    complex_t* signal = allocate_complex_array(n);
+    complex_t* zoom_spectrum = allocate_complex_array(n);
 
-    //Select method to dispay
-    for(int i=0;i<3;i++){
-        if(strcmp(method,methods[i]) == 0)
-        idx = i;
+    if(idx == METHOD_PHASE_VOCODER){
+        pv = phase_vocoder_create(n, hop, sample_rate);
+    }
+    if(idx == METHOD_HARMONIC){
+        peak_config_t peak_config = peak_default_config();
+        peak_engine = peak_engine_create(n, sample_rate, &peak_config);
+        peaks = fft_malloc(peak_config.max_peaks * sizeof(peak_t));
+        CHECK_NULL(peaks, "Failed to allocate peak list");
     }
     // Main loop
-    while(sound_position < sound.samples){
-        complex_t* signal = allocate_complex_array(n);
+    while(frame_start < sound.samples){
+        STATS_BEGIN(frame_span);
+        STATS_BEGIN(convert_span);
         for(int i=0; i < n;i++){
+            uint32_t sound_position = frame_start + i;
             if(sound_position < sound.samples){
-                signal[i] = (double)sound.data[sound_position++] + 0*I;
+                signal[i] = (double)sound.data[sound_position] + 0*I;
             }
             else{
                 signal[i] = 0.0 + 0*I;
             }
         }
+        STATS_END(STATS_CONVERT, convert_span);
+        double timestamp = frame_start / sample_rate;
+        uint32_t frame_first = frame_start;
+        frame_start += hop;
         num_frame++;
-        double energy = compute_energy(signal,n);
+        STATS_BEGIN(energy_span);
+        double energy = frame_energy(signal,n);
         double energy_ratio = curr_energy/energy;
+        STATS_END(STATS_DETECT, energy_span);
         
         //energy of next frames is rising == new note
         // if(num_frame > 15 && num_frame << 19){
@@ -105,16 +209,115 @@ void analyze_wav_file(sound_t sound, int n, double sample_rate, const char* meth
         //     display_spectrum_ascii_v2(magnitude,freq_number,fundamental_freq);
         //     free_complex_array(spectrum);    
         // }
-        if(energy_ratio < 1){
-            apply_window_hann(signal, n);
-            complex_t* spectrum = allocate_complex_array(n);
+        if(idx == METHOD_PHASE_VOCODER){
+            // Every frame goes through the vocoder to keep its phases one hop apart
+            STATS_BEGIN(window_span);
+            frame_window(signal, window, n);
+            STATS_END(STATS_WINDOW, window_span);
+            STATS_BEGIN(transform_span);
+            radix2_dit_fft(signal, n, FFT_FORWARD);
+            STATS_END(STATS_TRANSFORM, transform_span);
+            STATS_BEGIN(detect_span);
+            double pitch = detect_pitch_phase_vocoder(pv, signal);
+            STATS_END(STATS_DETECT, detect_span);
+            if(energy_ratio < 1){
+                emit_pitch(sink, num_frame, timestamp, idx, pitch, NAN);
+            }
+        }
+        else if(energy_ratio < 1 && idx == METHOD_CASCADE){
+            cascade_stage_t stage;
+            STATS_BEGIN(detect_span);
+            pitch_result_t result = detect_pitch_cascade(signal, n, sample_rate, &cascade, &stage);
+            STATS_END(STATS_DETECT, detect_span);
+            stage_counts[stage]++;
+            if(stage != CASCADE_STAGE_SILENT){
+                emit_pitch(sink, num_frame, timestamp, idx, result.frequency, result.confidence);
+            }
+        }
+        else if(energy_ratio < 1 && idx == METHOD_ZOOM){
+            // Coarse FFT peak refined with a chirp-z band of +/- 1 bin
+            STATS_BEGIN(window_span);
+            frame_window(signal, window, n);
+            STATS_END(STATS_WINDOW, window_span);
+            STATS_BEGIN(transform_span);
+            memcpy(zoom_spectrum, signal, n * sizeof(complex_t));
+            radix2_dit_fft(zoom_spectrum, n, FFT_FORWARD);
+            STATS_END(STATS_TRANSFORM, transform_span);
+            STATS_BEGIN(detect_span);
+            double coarse = detect_pitch_peak(zoom_spectrum, n, sample_rate);
+            double pitch = detect_pitch_zoom(signal, n, sample_rate, coarse, 1.0, 64, NULL);
+            STATS_END(STATS_DETECT, detect_span);
+            emit_pitch(sink, num_frame, timestamp, idx, pitch, NAN);
+        }
+        else if(energy_ratio < 1 && idx == METHOD_AMDF){
+            // Straight on the 16-bit samples: no window, no transform
+            uint32_t available = sound.samples - frame_first;
+            STATS_BEGIN(detect_span);
+            double clarity;
+            double pitch = detect_pitch_amdf(sound.data + frame_first, available < (uint32_t)n ? (int)available : n,
+                                             sample_rate, 80.0, 1000.0, &clarity);
+            STATS_END(STATS_DETECT, detect_span);
+            emit_pitch(sink, num_frame, timestamp, idx, pitch, clarity);
+        }
+        else if(energy_ratio < 1 && idx == METHOD_HARMONIC){
+            STATS_BEGIN(window_span);
+            frame_window(signal, window, n);
+            STATS_END(STATS_WINDOW, window_span);
+            STATS_BEGIN(transform_span);
+            radix2_dit_fft(signal, n, FFT_FORWARD);
+            STATS_END(STATS_TRANSFORM, transform_span);
+            STATS_BEGIN(detect_span);
+            double salience;
+            int count = peak_engine_run(peak_engine, signal, peaks);
+            double pitch = detect_pitch_harmonic_peaks(peaks, count, HARMONIC_PEAKS_HARMONICS, &salience);
+            STATS_END(STATS_DETECT, detect_span);
+            emit_pitch(sink, num_frame, timestamp, idx, pitch, salience);
+        }
+        else if(energy_ratio < 1 && idx == METHOD_HPS){
+            STATS_BEGIN(window_span);
+            frame_window(signal, window, n);
+            STATS_END(STATS_WINDOW, window_span);
+            STATS_BEGIN(transform_span);
+            radix2_dit_fft(signal, n, FFT_FORWARD);
+            STATS_END(STATS_TRANSFORM, transform_span);
+            STATS_BEGIN(detect_span);
+            pitches[idx] = detect_pitch_hps(signal, n, sample_rate, CACHE_HPS_HARMONICS);
+            STATS_END(STATS_DETECT, detect_span);
+            emit_pitch(sink, num_frame, timestamp, idx, pitches[idx], NAN);
+        }
+        else if(energy_ratio < 1 && idx == METHOD_AUTOCORR){
+            // On the unwindowed frame, the window would favour short lags
+            STATS_BEGIN(detect_span);
+            pitches[idx] = detect_pitch_autocorr(signal, n, sample_rate);
+            STATS_END(STATS_DETECT, detect_span);
+            emit_pitch(sink, num_frame, timestamp, idx, pitches[idx], NAN);
+        }
+        else if(energy_ratio < 1 && idx == METHOD_CEPSTRUM){
+            STATS_BEGIN(window_span);
+            frame_window(signal, window, n);
+            STATS_END(STATS_WINDOW, window_span);
+            STATS_BEGIN(transform_span);
+            radix2_dit_fft(signal, n, FFT_FORWARD);
+            STATS_END(STATS_TRANSFORM, transform_span);
+            STATS_BEGIN(detect_span);
+            double pitch = detect_pitch_cepstrum(signal, n, sample_rate);
+            STATS_END(STATS_DETECT, detect_span);
+            emit_pitch(sink, num_frame, timestamp, idx, pitch, NAN);
+        }
+        else if(energy_ratio < 1){
+            STATS_BEGIN(window_span);
+            frame_window(signal, window, n);
+            STATS_END(STATS_WINDOW, window_span);
+            STATS_BEGIN(transform_span);
             //memcpy(spectrum, signal, n * sizeof(complex_t));
-            spectrum = compute_ndft(signal,n,fundamental_freq,freq_number);
+            complex_t* spectrum = compute_ndft(signal,n,fundamental_freq,freq_number);
             //radix2_dit_fft(spectrum, n, FFT_FORWARD);
-            double *pitches = calloc(3,sizeof(double));
+            STATS_END(STATS_TRANSFORM, transform_span);
+            STATS_BEGIN(detect_span);
             // Method 1: Simple Maximum Peak
             // pitches[0] = detect_pitch_peak(spectrum,n,sample_rate);
             pitches[0] = detect_pitch_peak_v2(spectrum, freq_number, fundamental_freq);
+            STATS_END(STATS_DETECT, detect_span);
             // // Method 2: HPS
             // pitches[1] = detect_pitch_hps(spectrum, n, sample_rate, 3);
         
@@ -134,35 +337,739 @@ void analyze_wav_file(sound_t sound, int n, double sample_rate, const char* meth
             // //     display_current_pitch_wav(curr_pitches,confidence,num_frame, method);
             // // }
             // display_current_pitch_wav(energy_ratio,pitches,confidence,num_frame, method);
-            printf("Frame:%d\n",num_frame);
-            printf("Energy: %.1f\n",energy_ratio);
-            printf("Method: %s\n",methods[idx]);
-            printf("Detected pitch: %.2f Hz\n", pitches[idx]);
-            printf("Musical note: %s\n", frequency_to_note_name(pitches[idx]));
+            emit_pitch(sink, num_frame, timestamp, idx, pitches[idx], NAN);
             free_complex_array(spectrum);
         }
         curr_energy = energy;
-        free_complex_array(signal);
+        STATS_END_FRAME(frame_span);
+    }
+    phase_vocoder_free(pv);
+    peak_engine_free(peak_engine);
+    fft_free(peaks);
+    free_complex_array(zoom_spectrum);
+    free_complex_array(signal);
+    fft_free(window);
+    fft_free(pitches);
+    fft_free(curr_pitches);
+    if(idx == METHOD_CASCADE){
+        fprintf(stderr,"Cascade stages:");
+        for(int i=0;i<CASCADE_STAGE_COUNT;i++){
+            fprintf(stderr," %s=%d",cascade_stage_names[i],stage_counts[i]);
+        }
+        fprintf(stderr,"\n");
+    }
+}
+// Semitone analysis (Maximum Peak) with the note bank: the frames that pass
+// the energy gate are collected and projected NOTE_BANK_BLOCK at a time
+// instead of running compute_ndft per frame. Output matches analyze_wav_file.
+void analyze_wav_file_note_bank(sound_t sound, int n, int hop, double sample_rate, result_sink_t* sink){
+    uint32_t frame_start = 0;
+    double curr_energy = 0.0;
+    int num_frame = 0;
+    double* window = window_table(n, WINDOW_HANN);
+    note_bank_t* bank = note_bank_create(n, fundamental_freq, freq_number, window, NOTE_BANK_BLOCK);
+    complex_t* signal = allocate_complex_array(n);
+    double* frames = fft_malloc((size_t)NOTE_BANK_BLOCK * n * sizeof(double));
+    complex_t* spectra = allocate_complex_array(NOTE_BANK_BLOCK * freq_number);
+    int frame_numbers[NOTE_BANK_BLOCK];
+    double timestamps[NOTE_BANK_BLOCK];
+    CHECK_NULL(frames, "Failed to allocate note bank frames");
+
+    while(frame_start < sound.samples){
+        STATS_BEGIN(frame_span);
+        int gathered = 0;
+        int read = 0;   // frames of this block, gated ones included
+        while(gathered < NOTE_BANK_BLOCK && frame_start < sound.samples){
+            STATS_BEGIN(convert_span);
+            for(int i=0; i < n;i++){
+                uint32_t sound_position = frame_start + i;
+                signal[i] = (sound_position < sound.samples) ? (double)sound.data[sound_position] : 0.0;
+            }
+            STATS_END(STATS_CONVERT, convert_span);
+            double timestamp = frame_start / sample_rate;
+            frame_start += hop;
+            num_frame++;
+            read++;
+            STATS_BEGIN(energy_span);
+            double energy = frame_energy(signal,n);
+            double energy_ratio = curr_energy/energy;
+            STATS_END(STATS_DETECT, energy_span);
+            curr_energy = energy;
+            if(energy_ratio < 1){
+                // The window is folded into the bank, frames go in unwindowed
+                double* row = frames + (size_t)gathered * n;
+                for(int i=0; i < n;i++){
+                    row[i] = creal(signal[i]);
+                }
+                frame_numbers[gathered] = num_frame;
+                timestamps[gathered] = timestamp;
+                gathered++;
+            }
+        }
+
+        STATS_BEGIN(transform_span);
+        note_bank_project(bank, frames, gathered, spectra);
+        STATS_END(STATS_TRANSFORM, transform_span);
+        for(int b=0; b < gathered; b++){
+            STATS_BEGIN(detect_span);
+            double pitch = detect_pitch_peak_v2(spectra + b * freq_number, freq_number, fundamental_freq);
+            STATS_END(STATS_DETECT, detect_span);
+            emit_pitch(sink, frame_numbers[b], timestamps[b], 0, pitch, NAN);
+        }
+        STATS_END_FRAMES(frame_span, read);
+    }
+
+    free_complex_array(spectra);
+    fft_free(frames);
+    free_complex_array(signal);
+    note_bank_free(bank);
+    fft_free(window);
+}
+
+// Offline HPS analysis: the frames that pass the energy gate are collected
+// and transformed `batch` at a time with fft_many. Framed and gated like
+// analyze_wav_file (one frame every `hop` samples), so the track matches
+// the per-frame HPS path. Maximum Peak is blocked through the note bank
+// instead (analyze_wav_file_note_bank); other methods have no batched path.
+void analyze_wav_file_batched(sound_t sound, int n, int hop, double sample_rate, int batch,
+                              result_sink_t* sink){
+    uint32_t frame_start = 0; //First sample of the next frame, advances by hop
+    double curr_energy = 0.0;
+    int num_frame = 0;
+
+    complex_t* frame = allocate_complex_array(n);
+    complex_t* spectra = allocate_complex_array(n * batch);
+    double* window = window_table(n, WINDOW_HANN);
+    double *pitches = fft_calloc(batch,sizeof(double));
+    int *frame_numbers = fft_malloc(batch * sizeof(int));
+    double *timestamps = fft_malloc(batch * sizeof(double));
+    CHECK_NULL(frame, "Failed to allocate frame");
+    CHECK_NULL(spectra, "Failed to allocate batch buffer");
+    CHECK_NULL(pitches, "Failed to allocate pitch buffer");
+    CHECK_NULL(frame_numbers, "Failed to allocate frame numbers");
+    CHECK_NULL(timestamps, "Failed to allocate timestamps");
+
+    while(frame_start < sound.samples){
+        // Fill up to `batch` windowed frames directly into the interleaved buffer
+        STATS_BEGIN(frame_span);
+        int frames = 0;
+        int read = 0;   // frames of this batch, gated ones included
+        while(frames < batch && frame_start < sound.samples){
+            STATS_BEGIN(convert_span);
+            for(int i=0; i < n;i++){
+                uint32_t sound_position = frame_start + i;
+                frame[i] = (sound_position < sound.samples) ? (double)sound.data[sound_position] : 0.0;
+            }
+            STATS_END(STATS_CONVERT, convert_span);
+            double timestamp = frame_start / sample_rate;
+            frame_start += hop;
+            num_frame++;
+            read++;
+            STATS_BEGIN(energy_span);
+            double energy = frame_energy(frame,n);
+            double energy_ratio = curr_energy/energy;
+            STATS_END(STATS_DETECT, energy_span);
+            curr_energy = energy;
+            if(!(energy_ratio < 1)){
+                continue;
+            }
+            STATS_BEGIN(window_span);
+            frame_window(frame, window, n);
+            STATS_END(STATS_WINDOW, window_span);
+            STATS_BEGIN(interleave_span);
+            for(int i=0; i < n;i++){
+                spectra[i * batch + frames] = frame[i];
+            }
+            STATS_END(STATS_CONVERT, interleave_span);
+            frame_numbers[frames] = num_frame;
+            timestamps[frames] = timestamp;
+            frames++;
+        }
+        if(frames > 0){
+            for(int b=frames; b < batch; b++){
+                for(int i=0; i < n;i++){
+                    spectra[i * batch + b] = 0.0;
+                }
+            }
+
+            STATS_BEGIN(transform_span);
+            fft_many(spectra, n, batch, FFT_FORWARD);
+            STATS_END(STATS_TRANSFORM, transform_span);
+            STATS_BEGIN(detect_span);
+            detect_pitch_hps_many(spectra, n, batch, sample_rate, CACHE_HPS_HARMONICS, pitches);
+            STATS_END(STATS_DETECT, detect_span);
+            for(int b=0; b < frames; b++){
+                emit_pitch(sink, frame_numbers[b], timestamps[b], METHOD_HPS, pitches[b], NAN);
+            }
+        }
+        STATS_END_FRAMES(frame_span, read);
+    }
+
+    fft_free(timestamps);
+    fft_free(frame_numbers);
+    fft_free(window);
+    fft_free(pitches);
+    free_complex_array(spectra);
+    free_complex_array(frame);
+}
+
+// Integer pipeline: int16 PCM -> Q15 window -> block floating point FFT ->
+// integer |X|^2 peak search, no complex_t frames at all
+void analyze_wav_file_fixed(sound_t sound, int n, int hop, double sample_rate, result_sink_t* sink){
+    uint32_t frame_start = 0;
+    int64_t curr_energy = 0;
+    int num_frame = 0;
+    int16_t* window = window_table_q15(n, WINDOW_HANN);
+    cq15_t* frame = fft_malloc(n * sizeof(cq15_t));
+    CHECK_NULL(frame, "Failed to allocate fixed-point frame");
+
+    while(frame_start < sound.samples){
+        STATS_BEGIN(frame_span);
+        STATS_BEGIN(energy_span);
+        int64_t energy = 0;
+        for(int i=0; i < n && frame_start + i < sound.samples;i++){
+            energy += (int32_t)sound.data[frame_start + i] * sound.data[frame_start + i];
+        }
+        STATS_END(STATS_DETECT, energy_span);
+        double timestamp = frame_start / sample_rate;
+        num_frame++;
+
+        //energy of next frames is rising == new note
+        if(curr_energy < energy){
+            STATS_BEGIN(convert_span);
+            fft_fixed_load_q15(sound.data, sound.samples, frame_start, n, window, frame);
+            STATS_END(STATS_CONVERT, convert_span);
+            STATS_BEGIN(transform_span);
+            fft_fixed_q15(frame, n, FFT_FORWARD);
+            STATS_END(STATS_TRANSFORM, transform_span);
+            STATS_BEGIN(detect_span);
+            double pitch = detect_pitch_peak_q15(frame, n, sample_rate);
+            STATS_END(STATS_DETECT, detect_span);
+            emit_pitch(sink, num_frame, timestamp, METHOD_FIXED, pitch, NAN);
+        }
+        curr_energy = energy;
+        frame_start += hop;
+        STATS_END_FRAME(frame_span);
+    }
+
+    fft_free(frame);
+    fft_free(window);
+}
+
+// One merged pitch track from per-register frame sizes
+void analyze_wav_file_multires(sound_t sound, int hop, double sample_rate, result_sink_t* sink){
+    multires_band_t bands[MULTIRES_MAX_BANDS];
+    int num_bands = multires_default_bands(bands);
+    int num_points;
+    multires_point_t* track = multires_analyze(sound.data, sound.samples, sample_rate, hop,
+                                               bands, num_bands, &num_points);
+
+    for(int b=0;b<num_bands;b++){
+        fprintf(stderr,"Register %.0f-%.0f Hz: decimation %d, FFT %d\n",
+                bands[b].f_lo, bands[b].f_hi, bands[b].decimation, bands[b].n);
+    }
+    for(int p=0;p<num_points;p++){
+        if(track[p].band >= 0){
+            emit_pitch(sink, p + 1, track[p].timestamp, METHOD_MULTIRES,
+                       track[p].frequency, track[p].confidence);
+        }
+    }
+    fft_free(track);
+}
+
+// Re-run peak detection over a time range of an exported spectrogram
+bool query_spectrogram(const char* path, double from, double to, result_sink_t* sink){
+    spectrogram_t sg;
+    if(!spectrogram_open(path, &sg)){
+        return false;
+    }
+    int n = sg.header->n;
+    double sample_rate = sg.header->sample_rate;
+    double *magnitude = fft_malloc(sg.header->bins * sizeof(double));
+    CHECK_NULL(magnitude, "Failed to allocate magnitude array");
+
+    for(uint64_t f = spectrogram_frame_at(&sg, from); f < sg.header->num_frames; f++){
+        double time = spectrogram_frame_time(&sg, f);
+        if(time > to){
+            break;
+        }
+        spectrogram_frame_magnitude(&sg, f, magnitude);
+        double pitch = detect_pitch_peak_magnitude(magnitude, n, sample_rate);
+        emit_pitch(sink, (int)f + 1, time, 0, pitch, NAN);
+    }
+
+    fft_free(magnitude);
+    spectrogram_close(&sg);
+    return true;
+}
+
+// Settings shared by single-file runs and corpus workers
+typedef struct {
+    const char* method;
+    int n;
+    int hop;
+    int batch;
+    result_format_t format;
+    const char* cache_dir;
+    bool text;             // progress lines on stdout
+    bool track;            // smooth the pitches with the HMM tracker
+    int track_lag;         // tracker decision lag in frames
+    prefilter_config_t prefilter;
+} track_options_t;
+
+// Hash of the tuning tables behind every note and semitone decision: the
+// note bank / NDFT fundamentals and bin count, and the note name table.
+// Part of the cache key, so editing a table retires the old entries.
+static uint64_t tuning_hash(void){
+    uint64_t h = result_cache_hash(fundamental_freq, sizeof(fundamental_freq), 0);
+    h = result_cache_hash(&freq_number, sizeof(freq_number), h);
+    for(int i = 0; i < num_notes; i++){
+        h = result_cache_hash(notes[i].name, strlen(notes[i].name), h);
+        h = result_cache_hash(&notes[i].frequency, sizeof(notes[i].frequency), h);
+    }
+    return h;
+}
+
+// Pitch track of one recording into `out`. Tracks are cached by
+// recording content and configuration; a hit skips decoding and every
+// transform. `preloaded` is a recording already in memory (freed here) or
+// NULL. Adds the recording length to *audio_seconds.
+bool analyze_track(const char* wav_path, sound_t* preloaded, FILE* out, const track_options_t* opt,
+                   double* audio_seconds){
+    sound_t sound;
+    result_cache_key_t cache_key;
+    bool cacheable = false;
+    if(opt->cache_dir != NULL){
+        char config[256];
+        snprintf(config, sizeof(config),
+                 "method=%s n=%d hop=%d batch=%d window=hann hps=%d tuning=%016llx engine=%s track=%d "
+                 "filter=%s:%.1f:%.1f:%d:%.3f",
+                 opt->method, opt->n, opt->hop, opt->batch, CACHE_HPS_HARMONICS,
+                 (unsigned long long)tuning_hash(), fft_engine_name(fft_get_engine()), opt->track ? opt->track_lag : -1,
+                 prefilter_name(opt->prefilter.type), opt->prefilter.low_hz, opt->prefilter.high_hz,
+                 opt->prefilter.taps, opt->prefilter.coefficient);
+        if(preloaded != NULL){
+            // Hash the samples already in memory instead of mapping the file again
+            result_cache_key_sound(opt->cache_dir, preloaded, config, &cache_key);
+            sound = *preloaded;
+            cacheable = true;
+        }
+        else{
+            cacheable = result_cache_key(opt->cache_dir, wav_path, config, &cache_key, &sound);
+        }
+    }
+    FILE* cached = cacheable ? result_cache_lookup(&cache_key) : NULL;
+    if(cached != NULL){
+        if(preloaded != NULL){
+            free(preloaded->data);
+        }
+        if(opt->text){
+            printf("Sound samples: %d\n",sound.samples);
+            printf("Bytes per second: %d\n",sound.bytes_per_second);
+            printf("Pitch track served from cache\n");
+        }
+        fflush(stdout);
+        result_sink_t* sink = result_sink_open(out, opt->format, methods, 1);
+        CHECK_NULL(sink, "Failed to create result sink");
+        result_cache_replay(cached, sink);
+        result_sink_close(sink);
+        *audio_seconds += (double)sound.samples / sound.sample_rate;
+        return true;
+    }
+
+    if(preloaded != NULL){
+        sound = *preloaded;
     }
+    else{
+        STATS_BEGIN(load_span);
+        bool loaded = LoadWav(wav_path, &sound);
+        STATS_END(STATS_LOAD, load_span);
+        if(!loaded) {
+            PRINT_ERROR("Failed to load %s", wav_path);
+            return false;
+        }
+    }
+    double sample_rate = sound.sample_rate;
+    if(opt->prefilter.type != PREFILTER_NONE){
+        // Filter the whole recording as a stream before it is cut into frames
+        STATS_BEGIN(filter_span);
+        prefilter_t* filter = prefilter_create(&opt->prefilter, sample_rate);
+        prefilter_apply(filter, sound.data, sound.samples);
+        prefilter_free(filter);
+        STATS_END(STATS_FILTER, filter_span);
+    }
+    if(opt->text){
+        printf("Sound samples: %d\n",sound.samples);
+        printf("Bytes per second: %d\n",sound.bytes_per_second);
+        printf("Wav file loaded succesfully\n");
+    }
+    fflush(stdout);
+
+    result_sink_t* sink = result_sink_open(out, opt->format, methods, 1);
+    CHECK_NULL(sink, "Failed to create result sink");
+    FILE* cache_entry = NULL;
+    if(cacheable){
+        cache_entry = result_cache_begin(&cache_key);
+        result_sink_capture(sink, cache_entry);
+    }
+    if(opt->track){
+        pitch_tracker_config_t config = pitch_tracker_default_config();
+        config.lag = opt->track_lag;
+        tracking.tracker = pitch_tracker_create(&config, emit_tracked, NULL);
+        tracking.sink = sink;
+    }
+    if(opt->batch > 0 && strcmp(opt->method, methods[METHOD_HPS]) == 0){
+        analyze_wav_file_batched(sound,opt->n,opt->hop,sample_rate,opt->batch,sink);
+    }
+    else if(strcmp(opt->method, methods[METHOD_MULTIRES]) == 0){
+        analyze_wav_file_multires(sound,opt->hop,sample_rate,sink);
+    }
+    else if(strcmp(opt->method, methods[METHOD_FIXED]) == 0){
+        analyze_wav_file_fixed(sound,opt->n,opt->hop,sample_rate,sink);
+    }
+    else if(strcmp(opt->method, methods[0]) == 0){
+        analyze_wav_file_note_bank(sound,opt->n,opt->hop,sample_rate,sink);
+    }
+    else{
+        analyze_wav_file(sound,opt->n,opt->hop,sample_rate,opt->method,sink);
+    }
+    if(tracking.tracker != NULL){
+        pitch_tracker_flush(tracking.tracker);
+        pitch_tracker_free(tracking.tracker);
+        tracking.tracker = NULL;
+    }
+    result_sink_close(sink);
+    if(cache_entry != NULL){
+        result_cache_commit(&cache_key, cache_entry);
+    }
+    *audio_seconds += sound.samples / sample_rate;
+    free(sound.data);
+    return true;
 }
+
+// Corpus worker state: shared options and the audio analyzed so far
+typedef struct {
+    const track_options_t* opt;
+    double audio_seconds;
+} corpus_worker_t;
+
+// Corpus worker: one result file per manifest entry
+static bool analyze_corpus_file(const char* wav_path, sound_t* sound, const char* out_path, void* ctx){
+    corpus_worker_t* worker = (corpus_worker_t*)ctx;
+    const track_options_t* opt = worker->opt;
+    FILE* out = fopen(out_path, (opt->format == RESULT_FORMAT_BINARY) ? "wb" : "w");
+    if(out == NULL){
+        PRINT_ERROR("Failed to open %s", out_path);
+        if(sound != NULL){
+            free(sound->data);
+        }
+        return false;
+    }
+    STATS_FILE_BEGIN(worker->audio_seconds);
+    bool ok = analyze_track(wav_path, sound, out, opt, &worker->audio_seconds);
+    STATS_FILE_END(wav_path, worker->audio_seconds);
+    if(fclose(out) != 0){
+        ok = false;
+    }
+    return ok;
+}
+
 // Main demonstration
-int main() {
-    printf("Music Pitch Detection using FFT\n");
-    printf("================================\n\n");
+int main(int argc, char** argv) {
+    const char* wav_path = "wav/guitar-pack-g-string.wav";
+    const char* method = methods[0];
+    int batch = 0;
+    bool whole_file = false;
+    result_format_t format = RESULT_FORMAT_TEXT;
+    const char* output_path = NULL;
+    const char* export_path = NULL;
+    const char* query_path = NULL;
+    double query_from = 0;
+    double query_to = INFINITY;
+    int hop = 0;
+    bool track_pitches = false;
+    int track_lag = pitch_tracker_default_config().lag;
+    prefilter_config_t prefilter = prefilter_default_config();
+    bool stats = false;
+    bool autotune = false;
+    const char* wisdom_path = NULL;
+    const char* cache_dir = NULL;
+    const char* generate_path = NULL;
+    synth_config_t synth = synth_default_config();
+    corpus_config_t corpus = corpus_default_config();
+
+    for(int i=1;i<argc;i++){
+        if(strcmp(argv[i],"--method") == 0 && i + 1 < argc){
+            method = argv[++i];
+            if(method_index(method) < 0){
+                PRINT_ERROR("Unknown method: %s", method);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i],"--batch") == 0 && i + 1 < argc){
+            batch = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--engine") == 0 && i + 1 < argc){
+            int engine = fft_engine_from_name(argv[++i]);
+            if(engine < 0){
+                PRINT_ERROR("Unknown FFT engine: %s", argv[i]);
+                return 1;
+            }
+            fft_set_engine(engine);
+        }
+        else if(strcmp(argv[i],"--wisdom") == 0 && i + 1 < argc){
+            wisdom_path = argv[++i];
+        }
+        else if(strcmp(argv[i],"--cache") == 0 && i + 1 < argc){
+            cache_dir = argv[++i];
+        }
+        else if(strcmp(argv[i],"--generate") == 0 && i + 1 < argc){
+            generate_path = argv[++i];
+        }
+        else if(strcmp(argv[i],"--duration") == 0 && i + 1 < argc){
+            synth.duration = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--rate") == 0 && i + 1 < argc){
+            synth.sample_rate = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--seed") == 0 && i + 1 < argc){
+            synth.seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i],"--manifest") == 0 && i + 1 < argc){
+            corpus.manifest = argv[++i];
+        }
+        else if(strcmp(argv[i],"--out-dir") == 0 && i + 1 < argc){
+            corpus.out_dir = argv[++i];
+        }
+        else if(strcmp(argv[i],"--shard-size") == 0 && i + 1 < argc){
+            corpus.shard_size = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--lease") == 0 && i + 1 < argc){
+            corpus.lease_seconds = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--prefetch") == 0 && i + 1 < argc){
+            corpus.prefetch = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--autotune") == 0){
+            autotune = true;
+        }
+        else if(strcmp(argv[i],"--threads") == 0 && i + 1 < argc){
+            fft_set_threads(atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i],"--format") == 0 && i + 1 < argc){
+            int f = result_format_from_name(argv[++i]);
+            if(f < 0){
+                PRINT_ERROR("Unknown output format: %s", argv[i]);
+                return 1;
+            }
+            format = f;
+        }
+        else if(strcmp(argv[i],"--output") == 0 && i + 1 < argc){
+            output_path = argv[++i];
+        }
+        else if(strcmp(argv[i],"--hop") == 0 && i + 1 < argc){
+            hop = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--export-spectrogram") == 0 && i + 1 < argc){
+            export_path = argv[++i];
+        }
+        else if(strcmp(argv[i],"--query-spectrogram") == 0 && i + 1 < argc){
+            query_path = argv[++i];
+        }
+        else if(strcmp(argv[i],"--from") == 0 && i + 1 < argc){
+            query_from = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--to") == 0 && i + 1 < argc){
+            query_to = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--whole-file") == 0){
+            whole_file = true;
+        }
+        else if(strcmp(argv[i],"--track") == 0){
+            track_pitches = true;
+        }
+        else if(strcmp(argv[i],"--track-lag") == 0 && i + 1 < argc){
+            track_pitches = true;
+            track_lag = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i],"--prefilter") == 0 && i + 1 < argc){
+            int type = prefilter_from_name(argv[++i]);
+            if(type < 0){
+                PRINT_ERROR("Unknown prefilter: %s", argv[i]);
+                return 1;
+            }
+            prefilter.type = type;
+        }
+        else if(strcmp(argv[i],"--prefilter-band") == 0 && i + 1 < argc){
+            if(sscanf(argv[++i], "%lf,%lf", &prefilter.low_hz, &prefilter.high_hz) != 2){
+                PRINT_ERROR("--prefilter-band expects LOW,HIGH in Hz: %s", argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i],"--stats") == 0){
+            stats = true;
+        }
+        else if(strcmp(argv[i],"--selfcheck") == 0){
+            bool ok = frame_kernels_selfcheck(stderr);
+            fft_engine_cleanup();
+            return ok ? 0 : 1;
+        }
+        else if(strcmp(argv[i],"--cascade") == 0){
+            method = methods[METHOD_CASCADE];
+        }
+        else{
+            wav_path = argv[i];
+        }
+    }
+
+    // Synthetic recording with ground truth in <path>.labels.csv
+    if(generate_path != NULL){
+        char labels_path[4096];
+        snprintf(labels_path, sizeof(labels_path), "%s.labels.csv", generate_path);
+        bool ok = synth_generate(generate_path, labels_path, &synth);
+        if(ok){
+            fprintf(stderr,"Wrote %.1f s at %d Hz to %s (labels in %s)\n",
+                    synth.duration, synth.sample_rate, generate_path, labels_path);
+        }
+        return ok ? 0 : 1;
+    }
+
+    // Tuned engines: load earlier wisdom, or measure now and keep it
+    if(autotune){
+        fft_autotune(AUTOTUNE_MIN_N, AUTOTUNE_MAX_N, stderr);
+        if(wisdom_path != NULL && !fft_wisdom_save(wisdom_path)){
+            return 1;
+        }
+    }
+    else if(wisdom_path != NULL && !fft_wisdom_load(wisdom_path)){
+        fprintf(stderr,"%s: no usable FFT wisdom, using the default engines\n", wisdom_path);
+    }
+
+    bool text = (format == RESULT_FORMAT_TEXT);
+
+    // Batched (blocked) analysis exists for Maximum Peak (note bank) and HPS (fft_many)
+    if(batch > 0 && strcmp(method, methods[0]) != 0 && strcmp(method, methods[METHOD_HPS]) != 0){
+        PRINT_ERROR("--batch supports %s and %s, not %s", methods[0], methods[METHOD_HPS], method);
+        return 1;
+    }
+
+    if(text){
+        printf("Music Pitch Detection using FFT\n");
+        printf("================================\n\n");
+    }
     
     double sample_rate = 44100;
     int n = 4096;
 
+    FILE* out = stdout;
+    if(output_path != NULL){
+        out = fopen(output_path, (format == RESULT_FORMAT_BINARY) ? "wb" : "w");
+        if(out == NULL){
+            PRINT_ERROR("Failed to open %s", output_path);
+            return 1;
+        }
+    }
     
-    printf("\nWav file analyze test\n\n");
-    sound_t sound;
-	if(!LoadWav("wav/guitar-pack-g-string.wav", &sound)) {
-		PRINT_ERROR("Failed to load cheers.wav");
-	}
+    if(query_path != NULL){
+        result_sink_t* sink = result_sink_open(out, format, methods, 1);
+        CHECK_NULL(sink, "Failed to create result sink");
+        bool ok = query_spectrogram(query_path, query_from, query_to, sink);
+        result_sink_close(sink);
+        if(out != stdout){
+            fclose(out);
+        }
+        return ok ? 0 : 1;
+    }
+
+    if(text){
+        printf("\nWav file analyze test\n\n");
+    }
+#ifdef PITCH_STATS
+    if(stats){
+        stats_enable();
+    }
+#else
+    if(stats){
+        fprintf(stderr,"--stats: built without PITCH_STATS, no instrumentation available\n");
+    }
+#endif
+    if(export_path == NULL){
+        // The phase vocoder needs overlapping frames to unwrap phase advances
+        if(hop <= 0 && strcmp(method, methods[METHOD_MULTIRES]) == 0){
+            hop = 1024;
+        }
+        if(hop <= 0){
+            hop = (strcmp(method, methods[METHOD_PHASE_VOCODER]) == 0) ? n / 4 : n;
+        }
+    }
+
+    track_options_t track;
+    track.method = method;
+    track.n = n;
+    track.hop = hop;
+    track.batch = batch;
+    track.format = format;
+    track.cache_dir = cache_dir;
+    track.text = text;
+    track.track = track_pitches;
+    track.track_lag = track_lag;
+    track.prefilter = prefilter;
+    double audio_seconds = 0;
+    bool ok = true;
+
+    if(corpus.manifest != NULL){
+        if(corpus.out_dir == NULL){
+            PRINT_ERROR("--manifest needs --out-dir");
+            return 1;
+        }
+        static const char* extensions[RESULT_FORMAT_COUNT] = {"txt", "jsonl", "csv", "bin"};
+        corpus.extension = extensions[format];
+        track.text = false;
+        corpus_worker_t worker = {&track, 0};
+        ok = corpus_run(&corpus, analyze_corpus_file, &worker);
+        audio_seconds = worker.audio_seconds;
+    }
+    else if(export_path != NULL || whole_file){
+        sound_t sound;
+        STATS_BEGIN(load_span);
+        bool loaded = LoadWav(wav_path, &sound);
+        STATS_END(STATS_LOAD, load_span);
+        if(!loaded) {
+            PRINT_ERROR("Failed to load %s", wav_path);
+            return 1;
+        }
+        sample_rate = sound.sample_rate;
+        if(export_path != NULL){
+            ok = spectrogram_export(export_path, sound.data, sound.samples, n,
+                                    hop > 0 ? hop : n, sample_rate, WINDOW_HANN);
+        }
+        else{
+            analyze_recording_spectrum(sound.data, sound.samples, sample_rate);
+        }
+        audio_seconds = sound.samples / sample_rate;
+        free(sound.data);
+    }
     else{
-        printf("Wav file loaded succesfully\n");
+        ok = analyze_track(wav_path, NULL, out, &track, &audio_seconds);
+    }
+    if(out != stdout){
+        fclose(out);
+    }
+#ifdef PITCH_STATS
+    if(stats){
+        stats_report(stderr, audio_seconds);
+    }
+#endif
+    fft_engine_cleanup();
+    find_peaks_cleanup();
+#ifdef PITCH_STATS
+    if(stats){
+        stats_report_leaks(stderr);
+    }
+#endif
+    if(!ok){
+        return 1;
     }
-    analyze_wav_file(sound,n,sample_rate,methods[0]);
     
     // // Test 1: Pure sine wave
     // printf("Test 1: Pure Sine Wave (A4 = 440 Hz)\n");
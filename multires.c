@@ -0,0 +1,242 @@
+#include "multires.h"
+#include "audio_spectrum.h"
+
+// Semitone ratio minus one: the relative frequency gap between neighbouring notes
+#define SEMITONE_GAP 0.0594630943592953
+
+// A register counts as voiced when its peak stands this far above the band mean
+#define MULTIRES_MIN_SALIENCE 0.8
+
+// Relative tolerance when checking that a higher register's peak is a
+// harmonic of a lower register's pitch
+#define MULTIRES_HARMONIC_TOLERANCE 0.03
+
+// Frames whose RMS is below this (16-bit scale) are treated as silence
+#define MULTIRES_SILENCE_RMS 50.0
+
+// Guitar-oriented default: low strings on a 4x decimated signal, middle
+// register at 2x, everything above at the full rate
+int multires_default_bands(multires_band_t* bands) {
+    multires_band_t defaults[] = {
+        {  70.0,  160.0, 4, 0},
+        { 160.0,  400.0, 2, 0},
+        { 400.0, 1400.0, 1, 0},
+    };
+    int count = sizeof(defaults) / sizeof(defaults[0]);
+    memcpy(bands, defaults, sizeof(defaults));
+    return count;
+}
+
+// Smallest power-of-two FFT whose bin spacing resolves a semitone at f_lo
+int multires_frame_size(double sample_rate, int decimation, double f_lo) {
+    double rate = sample_rate / decimation;
+    double max_spacing = f_lo * SEMITONE_GAP;
+    return next_power_of_two((int)ceil(rate / max_spacing));
+}
+
+// Low-pass (windowed sinc) and keep every `decimation`-th sample
+static double* decimate(const int16_t* samples, uint32_t count, int decimation, uint32_t* out_count) {
+    uint32_t m = (count + decimation - 1) / decimation;
+    double* out = (double*)fft_malloc((m ? m : 1) * sizeof(double));
+    CHECK_NULL(out, "Failed to allocate decimated signal");
+    *out_count = m;
+
+    if (decimation == 1) {
+        for (uint32_t i = 0; i < count; i++) out[i] = samples[i];
+        return out;
+    }
+
+    int taps = 16 * decimation + 1;
+    int half = taps / 2;
+    double cutoff = 0.45 / decimation;  // cycles per input sample
+    double* h = (double*)fft_malloc(taps * sizeof(double));
+    CHECK_NULL(h, "Failed to allocate decimation filter");
+
+    double sum = 0;
+    for (int k = 0; k < taps; k++) {
+        double t = k - half;
+        double sinc = (t == 0) ? 2 * cutoff : sin(TWO_PI * cutoff * t) / (PI * t);
+        double window = 0.54 - 0.46 * cos(TWO_PI * k / (taps - 1));
+        h[k] = sinc * window;
+        sum += h[k];
+    }
+    for (int k = 0; k < taps; k++) h[k] /= sum;
+
+    for (uint32_t i = 0; i < m; i++) {
+        long long centre = (long long)i * decimation;
+        double acc = 0;
+        for (int k = 0; k < taps; k++) {
+            long long pos = centre + k - half;
+            if (pos >= 0 && pos < count) acc += h[k] * samples[pos];
+        }
+        out[i] = acc;
+    }
+
+    fft_free(h);
+    return out;
+}
+
+// Largest magnitude within one bin of k
+static double magnitude_near(const complex_t* spectrum, int n, int k, int* where) {
+    double best = 0;
+    *where = k;
+    for (int i = k - 1; i <= k + 1; i++) {
+        if (i < 1 || i >= n / 2) continue;
+        double mag = cabs(spectrum[i]);
+        if (mag > best) {
+            best = mag;
+            *where = i;
+        }
+    }
+    return best;
+}
+
+// Strongest peak in [f_lo, f_hi] with quadratic interpolation. Salience is
+// 1 - (band mean / peak), close to 1 for a clean partial, and is halved
+// when neither the 2nd nor the 3rd harmonic backs the peak up (rumble and
+// noise peaks have no partials). A peak whose lower octave is also present
+// in the band is taken to be the 2nd harmonic.
+static double band_peak(const complex_t* spectrum, int n, double rate,
+                        double f_lo, double f_hi, double* salience) {
+    int min_bin = (int)floor(f_lo * n / rate);
+    int max_bin = (int)ceil(f_hi * n / rate);
+    if (min_bin < 1) min_bin = 1;
+    if (max_bin > n / 2 - 1) max_bin = n / 2 - 1;
+
+    *salience = 0;
+    if (max_bin <= min_bin) return 0;
+
+    double mean = 0;
+    double best = 0;
+    int best_bin = 0;
+    for (int k = min_bin; k <= max_bin; k++) {
+        double mag = cabs(spectrum[k]);
+        mean += mag;
+        if (mag > best) {
+            best = mag;
+            best_bin = k;
+        }
+    }
+    mean /= (max_bin - min_bin + 1);
+    if (best <= 0) return 0;
+
+    // Octave check
+    int lower;
+    if (best_bin / 2 >= min_bin &&
+        magnitude_near(spectrum, n, best_bin / 2, &lower) >= 0.2 * best) {
+        best_bin = lower;
+        best = cabs(spectrum[best_bin]);
+    }
+
+    double peak = best_bin;
+    double y1 = cabs(spectrum[best_bin - 1]);
+    double y3 = cabs(spectrum[best_bin + 1]);
+    double denom = y1 - 2 * best + y3;
+    if (denom != 0) peak += 0.5 * (y1 - y3) / denom;
+
+    *salience = 1.0 - mean / best;
+
+    int where;
+    double support = 0;
+    if (2 * best_bin < n / 2 - 1) support += magnitude_near(spectrum, n, 2 * best_bin, &where);
+    if (3 * best_bin < n / 2 - 1) support += magnitude_near(spectrum, n, 3 * best_bin, &where);
+    if (support < 0.1 * best) *salience *= 0.5;
+    return peak * rate / n;
+}
+
+// Analyze the recording every `hop` input samples. The lowest register with
+// a salient peak wins, since partials of a low note also show up as peaks
+// in the higher registers, unless a more salient peak above it is not one
+// of its harmonics.
+multires_point_t* multires_analyze(const int16_t* samples, uint32_t count, double sample_rate,
+                                   int hop, multires_band_t* bands, int num_bands,
+                                   int* num_points) {
+    double* signals[MULTIRES_MAX_BANDS];
+    uint32_t lengths[MULTIRES_MAX_BANDS];
+    complex_t* frames[MULTIRES_MAX_BANDS];
+
+    if (num_bands > MULTIRES_MAX_BANDS) num_bands = MULTIRES_MAX_BANDS;
+
+    for (int b = 0; b < num_bands; b++) {
+        if (bands[b].n <= 0) {
+            bands[b].n = multires_frame_size(sample_rate, bands[b].decimation, bands[b].f_lo);
+        }
+        signals[b] = decimate(samples, count, bands[b].decimation, &lengths[b]);
+        frames[b] = allocate_complex_array(bands[b].n);
+        CHECK_NULL(frames[b], "Failed to allocate multi-resolution frame");
+    }
+
+    int points = (int)((count + hop - 1) / hop);
+    multires_point_t* track = (multires_point_t*)fft_calloc(points ? points : 1, sizeof(multires_point_t));
+    CHECK_NULL(track, "Failed to allocate pitch track");
+
+    for (int p = 0; p < points; p++) {
+        long long centre = (long long)p * hop + hop / 2;
+        multires_point_t* point = &track[p];
+        point->timestamp = centre / sample_rate;
+        point->band = -1;
+
+        // Silence check on a short full-rate window around the centre
+        double sum_sq = 0;
+        int span = 0;
+        for (long long i = centre - hop / 2; i < centre + hop / 2; i++) {
+            if (i >= 0 && i < count) {
+                sum_sq += (double)samples[i] * samples[i];
+                span++;
+            }
+        }
+        if (span == 0 || sqrt(sum_sq / span) < MULTIRES_SILENCE_RMS) continue;
+
+        double pitch[MULTIRES_MAX_BANDS];
+        double salience[MULTIRES_MAX_BANDS];
+        for (int b = 0; b < num_bands; b++) {
+            int n = bands[b].n;
+            int dec = bands[b].decimation;
+            double rate = sample_rate / dec;
+            long long start = centre / dec - n / 2;
+
+            for (int i = 0; i < n; i++) {
+                long long pos = start + i;
+                frames[b][i] = (pos >= 0 && pos < lengths[b]) ? signals[b][pos] : 0.0;
+            }
+            apply_window_hann(frames[b], n);
+            radix2_dit_fft(frames[b], n, FFT_FORWARD);
+            pitch[b] = band_peak(frames[b], n, rate, bands[b].f_lo, bands[b].f_hi, &salience[b]);
+        }
+
+        int chosen = -1;
+        for (int b = 0; b < num_bands && chosen < 0; b++) {
+            if (pitch[b] <= 0 || salience[b] < MULTIRES_MIN_SALIENCE) continue;
+            chosen = b;
+            // A low peak that does not explain a more salient peak above it
+            // (resonance, rumble) is not the note being played
+            for (int c = b + 1; c < num_bands; c++) {
+                if (pitch[c] <= 0 || salience[c] <= salience[b]) continue;
+                double ratio = pitch[c] / pitch[b];
+                if (fabs(ratio - round(ratio)) > MULTIRES_HARMONIC_TOLERANCE * ratio) {
+                    chosen = -1;
+                    break;
+                }
+            }
+        }
+        if (chosen < 0) {
+            // Nothing clearly voiced: fall back to the most salient register
+            for (int b = 0; b < num_bands; b++) {
+                if (pitch[b] > 0 && (chosen < 0 || salience[b] > salience[chosen])) chosen = b;
+            }
+        }
+        if (chosen >= 0) {
+            point->frequency = pitch[chosen];
+            point->confidence = salience[chosen];
+            point->band = chosen;
+        }
+    }
+
+    for (int b = 0; b < num_bands; b++) {
+        fft_free(signals[b]);
+        free_complex_array(frames[b]);
+    }
+
+    *num_points = points;
+    return track;
+}
@@ -0,0 +1,33 @@
+#ifndef MULTIRES_H
+#define MULTIRES_H
+
+#include <stdint.h>
+#include "fft_common.h"
+#include "fft_algorithms.h"
+
+// Multi-resolution pitch analysis: each register (band of fundamentals)
+// is analyzed on a decimated copy of the signal with the smallest FFT
+// whose bin spacing resolves a semitone at the bottom of the band.
+#define MULTIRES_MAX_BANDS 8
+
+typedef struct {
+    double f_lo;        // lowest fundamental of the register (Hz)
+    double f_hi;        // highest fundamental of the register (Hz)
+    int decimation;     // input decimation factor
+    int n;              // FFT size at the decimated rate, 0 = choose automatically
+} multires_band_t;
+
+typedef struct {
+    double timestamp;   // centre of the analysis frames in seconds
+    double frequency;   // 0 if no register found a pitch
+    double confidence;  // peak salience of the chosen register (0..1)
+    int band;           // register that produced the pitch, -1 if none
+} multires_point_t;
+
+int multires_default_bands(multires_band_t* bands);
+int multires_frame_size(double sample_rate, int decimation, double f_lo);
+multires_point_t* multires_analyze(const int16_t* samples, uint32_t count, double sample_rate,
+                                   int hop, multires_band_t* bands, int num_bands,
+                                   int* num_points);
+
+#endif
@@ -0,0 +1,112 @@
+#include "note_bank.h"
+
+// Blocking: a micro-kernel keeps NOTE_BANK_MR frames x NOTE_BANK_NR
+// columns of accumulators in registers and streams one packed panel over
+// NOTE_BANK_KC samples. With KC = 256 the panel slice (16 KB) and the
+// frame slices (8 KB) stay in L1 while every frame block reuses them.
+#define NOTE_BANK_MR 4
+#define NOTE_BANK_KC 256
+
+note_bank_t* note_bank_create(int n, const double* fundamentals, int k, const double* window, int max_frames) {
+    note_bank_t* bank = fft_malloc(sizeof(note_bank_t));
+    CHECK_NULL(bank, "Failed to allocate note bank");
+    bank->n = n;
+    bank->k = k;
+    bank->panels = (2 * k + NOTE_BANK_NR - 1) / NOTE_BANK_NR;
+    bank->packed = fft_calloc((size_t)bank->panels * n * NOTE_BANK_NR, sizeof(double));
+    CHECK_NULL(bank->packed, "Failed to allocate note bank basis");
+    bank->max_frames = (max_frames > 0) ? max_frames : 1;
+    bank->scratch = fft_malloc((size_t)bank->max_frames * bank->panels * NOTE_BANK_NR * sizeof(double));
+    CHECK_NULL(bank->scratch, "Failed to allocate note bank accumulators");
+
+    // Same bin frequencies and phase expression as compute_ndft()
+    double exp = 0;
+    for (int i = 0; i < k; i++) {
+        double freq = fundamentals[i % 12] * pow(2, exp);
+        int p = (2 * i) / NOTE_BANK_NR;
+        int c = (2 * i) % NOTE_BANK_NR;
+        for (int j = 0; j < n; j++) {
+            complex_t w = cexp(I * (-1) * TWO_PI * j * freq / n);
+            double scale = window ? window[j] : 1.0;
+            double* row = bank->packed + ((size_t)p * n + j) * NOTE_BANK_NR;
+            row[c] = creal(w) * scale;
+            row[c + 1] = cimag(w) * scale;
+        }
+        exp++;
+    }
+    return bank;
+}
+
+void note_bank_free(note_bank_t* bank) {
+    if (bank == NULL) return;
+    fft_free(bank->scratch);
+    fft_free(bank->packed);
+    fft_free(bank);
+}
+
+// acc[r][c] += sum over len samples of x[r][j] * panel[j][c], MR frames
+FFT_TARGET_CLONES
+static void kernel_mr(const double* x, int stride, const double* panel, int len, double* c_out, int c_stride) {
+    double acc[NOTE_BANK_MR][NOTE_BANK_NR];
+    for (int r = 0; r < NOTE_BANK_MR; r++) {
+        for (int c = 0; c < NOTE_BANK_NR; c++) acc[r][c] = c_out[r * c_stride + c];
+    }
+    for (int j = 0; j < len; j++) {
+        const double* b = panel + j * NOTE_BANK_NR;
+        for (int r = 0; r < NOTE_BANK_MR; r++) {
+            double xr = x[r * stride + j];
+            for (int c = 0; c < NOTE_BANK_NR; c++) acc[r][c] += xr * b[c];
+        }
+    }
+    for (int r = 0; r < NOTE_BANK_MR; r++) {
+        for (int c = 0; c < NOTE_BANK_NR; c++) c_out[r * c_stride + c] = acc[r][c];
+    }
+}
+
+// Single frame, for the rows left over after the MR blocks
+FFT_TARGET_CLONES
+static void kernel_1(const double* x, const double* panel, int len, double* c_out) {
+    double acc[NOTE_BANK_NR];
+    for (int c = 0; c < NOTE_BANK_NR; c++) acc[c] = c_out[c];
+    for (int j = 0; j < len; j++) {
+        const double* b = panel + j * NOTE_BANK_NR;
+        for (int c = 0; c < NOTE_BANK_NR; c++) acc[c] += x[j] * b[c];
+    }
+    for (int c = 0; c < NOTE_BANK_NR; c++) c_out[c] = acc[c];
+}
+
+// One pass of at most max_frames frames
+static void project_block(note_bank_t* bank, const double* frames, int count, complex_t* out) {
+    int n = bank->n;
+    int cols = bank->panels * NOTE_BANK_NR;
+    double* c = bank->scratch;
+    memset(c, 0, (size_t)count * cols * sizeof(double));
+
+    for (int jb = 0; jb < n; jb += NOTE_BANK_KC) {
+        int len = (n - jb < NOTE_BANK_KC) ? n - jb : NOTE_BANK_KC;
+        for (int p = 0; p < bank->panels; p++) {
+            const double* panel = bank->packed + ((size_t)p * n + jb) * NOTE_BANK_NR;
+            int f = 0;
+            for (; f + NOTE_BANK_MR <= count; f += NOTE_BANK_MR) {
+                kernel_mr(frames + (size_t)f * n + jb, n, panel, len,
+                          c + (size_t)f * cols + p * NOTE_BANK_NR, cols);
+            }
+            for (; f < count; f++) {
+                kernel_1(frames + (size_t)f * n + jb, panel, len, c + (size_t)f * cols + p * NOTE_BANK_NR);
+            }
+        }
+    }
+
+    for (int f = 0; f < count; f++) {
+        for (int i = 0; i < bank->k; i++) {
+            out[(size_t)f * bank->k + i] = CMPLX(c[(size_t)f * cols + 2 * i], c[(size_t)f * cols + 2 * i + 1]);
+        }
+    }
+}
+
+void note_bank_project(note_bank_t* bank, const double* frames, int count, complex_t* out) {
+    for (int f = 0; f < count; f += bank->max_frames) {
+        int block = (count - f < bank->max_frames) ? count - f : bank->max_frames;
+        project_block(bank, frames + (size_t)f * bank->n, block, out + (size_t)f * bank->k);
+    }
+}
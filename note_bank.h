@@ -0,0 +1,33 @@
+#ifndef NOTE_BANK_H
+#define NOTE_BANK_H
+
+#include "fft_common.h"
+
+// Semitone note bank as a matrix product. compute_ndft() evaluates k note
+// bins of one frame at a time, recomputing every cexp(); across a file
+// that is a (frames x n) . (n x k) complex product with a fixed right-hand
+// side. The bank evaluates the basis once (same bin frequencies as
+// compute_ndft, with the analysis window folded in) and projects a block
+// of real frames at a time with a cache-blocked kernel.
+
+typedef struct {
+    int n;            // frame length
+    int k;            // notes
+    int panels;       // basis columns (re/im per note) in groups of NOTE_BANK_NR
+    double* packed;   // panel p, sample j, column c at [(p * n + j) * NOTE_BANK_NR + c]
+    int max_frames;   // frames per projection pass
+    double* scratch;  // accumulators, max_frames x panels * NOTE_BANK_NR
+} note_bank_t;
+
+#define NOTE_BANK_NR 8
+
+// Basis for compute_ndft(signal, n, fundamentals, k) on frames multiplied
+// by `window` (NULL for none). Projections run max_frames frames at a time
+// through accumulators allocated here, not per call.
+note_bank_t* note_bank_create(int n, const double* fundamentals, int k, const double* window, int max_frames);
+void note_bank_free(note_bank_t* bank);
+
+// out[f * k + i] = sum_j frames[f * n + j] * window[j] * basis_i(j)
+void note_bank_project(note_bank_t* bank, const double* frames, int count, complex_t* out);
+
+#endif
@@ -1,6 +1,8 @@
 #include "fft_common.h"
 #include "fft_algorithms.h"
 #include "pitch_detection.h"
+#include "frame_kernels.h"
+#include "stats.h"
 
 musical_note_t notes[] = {
     {"C0", 16.35}, {"C#0", 17.32}, {"D0", 18.35}, {"D#0", 19.45},
@@ -32,8 +34,8 @@ musical_note_t notes[] = {
 
 int num_notes = sizeof(notes) / sizeof(notes[0]);
 
-// Find closest musical note
-const char* frequency_to_note_name(double freq) {
+// Find closest musical note, returns its index and the offset in cents
+int frequency_to_note(double freq, double* cents) {
     int closest_idx = 0;
     double min_cents = 1200;  // Max cents difference
     
@@ -45,6 +47,19 @@ const char* frequency_to_note_name(double freq) {
         }
     }
     
+    if (cents) *cents = min_cents;
+    return closest_idx;
+}
+
+const char* note_name(int idx) {
+    if (idx < 0 || idx >= num_notes) return "-";
+    return notes[idx].name;
+}
+
+const char* frequency_to_note_name(double freq) {
+    double min_cents;
+    int closest_idx = frequency_to_note(freq, &min_cents);
+    
     static char result[32];
     if (fabs(min_cents) < 1) {
         snprintf(result, sizeof(result), "%s (in tune)", notes[closest_idx].name);
@@ -58,8 +73,19 @@ const char* frequency_to_note_name(double freq) {
 
 // Simple peak detection for fundamental frequency
 double detect_pitch_peak(complex_t* spectrum, int n, double sample_rate) {
-    double* magnitude = compute_magnitude(spectrum, n);
-    
+    // Only the n/2 + 1 non-negative frequency bins are searched
+    double* magnitude = (double*)fft_malloc((n/2 + 1) * sizeof(double));
+    CHECK_NULL(magnitude, "Failed to allocate magnitude array");
+    STATS_BEGIN(span);
+    frame_magnitude(spectrum, n/2 + 1, magnitude);
+    STATS_END(STATS_MAGNITUDE, span);
+    double pitch = detect_pitch_peak_magnitude(magnitude, n, sample_rate);
+    fft_free(magnitude);
+    return pitch;
+}
+
+// Peak detection on an already computed magnitude spectrum (n/2 + 1 bins)
+double detect_pitch_peak_magnitude(const double* magnitude, int n, double sample_rate) {
     // Find peak in reasonable frequency range (80-2000 Hz)
     int min_bin = (int)(80 * n / sample_rate);
     int max_bin = (int)(2000 * n / sample_rate);
@@ -76,21 +102,162 @@ double detect_pitch_peak(complex_t* spectrum, int n, double sample_rate) {
     }
     
     // Quadratic interpolation for more accurate frequency
+    double peak = peak_bin;
     if (peak_bin > 0 && peak_bin < n/2 - 1) {
         double y1 = magnitude[peak_bin - 1];
         double y2 = magnitude[peak_bin];
         double y3 = magnitude[peak_bin + 1];
         
-        double delta = 0.5 * (y1 - y3) / (y1 - 2*y2 + y3);
-        peak_bin += delta;
+        double denom = y1 - 2*y2 + y3;
+        if (denom != 0) {
+            peak += 0.5 * (y1 - y3) / denom;
+        }
     }
     
-    free(magnitude);
-    
-    return peak_bin * sample_rate / n;
+    return peak * sample_rate / n;
+}
+// Peak detection on a fixed-point spectrum: integer |X|^2 search over the
+// same 80-2000 Hz range, square roots only for the three bins that feed
+// the interpolation. The block exponent does not move the peak.
+double detect_pitch_peak_q15(const cq15_t* spectrum, int n, double sample_rate) {
+    int min_bin = (int)(80 * n / sample_rate);
+    int max_bin = (int)(2000 * n / sample_rate);
+    if (max_bin > n/2) max_bin = n/2;
+
+    uint32_t max_power = 0;
+    int peak_bin = 0;
+
+    for (int i = min_bin; i < max_bin; i++) {
+        // re^2 + im^2 <= 2^31 fits unsigned 32-bit
+        uint32_t power = (uint32_t)((int32_t)spectrum[i].re * spectrum[i].re) +
+                         (uint32_t)((int32_t)spectrum[i].im * spectrum[i].im);
+        if (power > max_power) {
+            max_power = power;
+            peak_bin = i;
+        }
+    }
+
+    double peak = peak_bin;
+    if (peak_bin > 0 && peak_bin < n/2 - 1) {
+        double y[3];
+        for (int j = 0; j < 3; j++) {
+            const cq15_t* c = &spectrum[peak_bin - 1 + j];
+            y[j] = sqrt((double)c->re * c->re + (double)c->im * c->im);
+        }
+        double denom = y[0] - 2*y[1] + y[2];
+        if (denom != 0) {
+            peak += 0.5 * (y[0] - y[2]) / denom;
+        }
+    }
+
+    return peak * sample_rate / n;
+}
+
+// Refine a coarse peak with a zoom (chirp-z) spectrum of the windowed frame:
+// `points` frequencies spread over +/- `span_bins` FFT bins around the peak
+double detect_pitch_zoom(complex_t* signal, int n, double sample_rate, double coarse_freq,
+                         double span_bins, int points, double* magnitude) {
+    double bin_width = sample_rate / n;
+    double f0 = coarse_freq - span_bins * bin_width;
+    double df = 2 * span_bins * bin_width / (points - 1);
+    if (f0 < 0) f0 = 0;
+
+    complex_t* band = allocate_complex_array(points);
+    CHECK_NULL(band, "Failed to allocate zoom band");
+    czt_zoom(signal, n, f0, df, points, sample_rate, band);
+
+    int best = 0;
+    double best_mag = 0;
+    for (int k = 0; k < points; k++) {
+        double mag = cabs(band[k]);
+        if (mag > best_mag) {
+            best_mag = mag;
+            best = k;
+        }
+    }
+
+    // Quadratic interpolation on the dense grid
+    double peak = best;
+    double peak_mag = best_mag;
+    if (best > 0 && best < points - 1) {
+        double y1 = cabs(band[best - 1]);
+        double y2 = best_mag;
+        double y3 = cabs(band[best + 1]);
+        double denom = y1 - 2*y2 + y3;
+        if (denom != 0) {
+            double delta = 0.5 * (y1 - y3) / denom;
+            peak += delta;
+            peak_mag = y2 - 0.25 * (y1 - y3) * delta;
+        }
+    }
+
+    free_complex_array(band);
+
+    if (magnitude) *magnitude = peak_mag;
+    return f0 + peak * df;
+}
+
+phase_vocoder_t* phase_vocoder_create(int n, int hop, double sample_rate) {
+    phase_vocoder_t* pv = (phase_vocoder_t*)fft_calloc(1, sizeof(phase_vocoder_t));
+    CHECK_NULL(pv, "Failed to allocate phase vocoder");
+    pv->n = n;
+    pv->hop = hop;
+    pv->sample_rate = sample_rate;
+    pv->prev_phase = (double*)fft_calloc(n, sizeof(double));
+    CHECK_NULL(pv->prev_phase, "Failed to allocate phase vocoder phases");
+    return pv;
+}
+
+void phase_vocoder_free(phase_vocoder_t* pv) {
+    if (pv) {
+        fft_free(pv->prev_phase);
+        fft_free(pv);
+    }
+}
+
+// Forget the previous frame (e.g. after a gap in the input)
+void phase_vocoder_reset(phase_vocoder_t* pv) {
+    pv->has_prev = 0;
 }
+
+// Instantaneous frequency of a bin from its phase advance over the hop.
+// A stationary sinusoid at bin k + d advances by 2*pi*(k + d)*hop/n, so
+// the deviation from the bin-centre advance gives d. Unambiguous while
+// |d| < n / (2 * hop) bins.
+double phase_vocoder_frequency(const phase_vocoder_t* pv, const double* phase, int bin) {
+    double expected = TWO_PI * bin * pv->hop / pv->n;
+    double deviation = phase[bin] - pv->prev_phase[bin] - expected;
+
+    // Wrap to [-pi, pi)
+    deviation -= TWO_PI * floor((deviation + PI) / TWO_PI);
+
+    double true_bin = bin + deviation * pv->n / (TWO_PI * pv->hop);
+    return true_bin * pv->sample_rate / pv->n;
+}
+
+// Peak pitch refined by the phase vocoder; the spectrum of every
+// consecutive frame must be passed so the stored phases stay one hop apart
+double detect_pitch_phase_vocoder(phase_vocoder_t* pv, complex_t* spectrum) {
+    int n = pv->n;
+    double coarse = detect_pitch_peak(spectrum, n, pv->sample_rate);
+    int bin = (int)floor(coarse * n / pv->sample_rate + 0.5);
+    double* phase = compute_phase(spectrum, n);
+
+    double pitch = coarse;
+    if (pv->has_prev && bin > 0 && bin < n / 2) {
+        pitch = phase_vocoder_frequency(pv, phase, bin);
+    }
+
+    memcpy(pv->prev_phase, phase, n * sizeof(double));
+    pv->has_prev = 1;
+    fft_free(phase);
+    return pitch;
+}
+
 double detect_pitch_peak_v2(complex_t* spectrum, int k,double *fundamentals){
+    STATS_BEGIN(span);
     double* magnitude = compute_magnitude(spectrum,k);
+    STATS_END(STATS_MAGNITUDE, span);
     
     double max_mag = 0;
     int freq_idx = 0;
@@ -101,26 +268,22 @@ double detect_pitch_peak_v2(complex_t* spectrum, int k,double *fundamentals){
             freq_idx = i;
         }
     }
-    free(magnitude);
+    fft_free(magnitude);
     return fundamentals[freq_idx%12]*pow(2,(int)freq_idx/12);
 }
 
 // Harmonic Product Spectrum (HPS) method
 double detect_pitch_hps(complex_t* spectrum, int n, double sample_rate, int harmonics) {
-    double* magnitude = compute_magnitude(spectrum, n);
-    double* hps = (double*)malloc((n/2 + 1) * sizeof(double));
+    double* magnitude = (double*)fft_malloc((n/2 + 1) * sizeof(double));
+    double* hps = (double*)fft_malloc((n/2 + 1) * sizeof(double));
+    CHECK_NULL(magnitude, "Failed to allocate magnitude array");
+    CHECK_NULL(hps, "Failed to allocate HPS array");
+    STATS_BEGIN(span);
+    frame_magnitude(spectrum, n/2 + 1, magnitude);
+    STATS_END(STATS_MAGNITUDE, span);
     
-    // Initialize HPS with original spectrum
-    for (int i = 0; i <= n/2; i++) {
-        hps[i] = magnitude[i];
-    }
-    
-    // Multiply with downsampled versions
-    for (int h = 2; h <= harmonics; h++) {
-        for (int i = 0; i <= n/(2*h); i++) {
-            hps[i] *= magnitude[i * h];
-        }
-    }
+    // Original spectrum times its downsampled versions
+    frame_hps_product(magnitude, n/2 + 1, harmonics, hps);
     
     // Find peak in HPS
     int min_bin = (int)(80 * n / sample_rate);
@@ -137,8 +300,8 @@ double detect_pitch_hps(complex_t* spectrum, int n, double sample_rate, int harm
         }
     }
     
-    free(magnitude);
-    free(hps);
+    fft_free(magnitude);
+    fft_free(hps);
     
     return peak_bin * sample_rate / n;
 }
@@ -187,6 +350,256 @@ double detect_pitch_autocorr(complex_t* signal, int n, double sample_rate) {
     return 0;
 }
 
+// Samples per partial AMDF sum; a lag is abandoned between blocks once its
+// sum can no longer beat the best lag so far
+#define AMDF_BLOCK 512
+
+// A refined dip below this fraction of the running mean is clear: the
+// coarse scan stops at the first one
+#define AMDF_DIP 0.3
+
+// Coarse lag steps across the search range
+#define AMDF_COARSE_STEPS 64
+
+static uint64_t amdf_sum(const int16_t* x, int len, int lag, uint64_t bound) {
+    uint64_t sum = 0;
+    for (int i = 0; i < len; i += AMDF_BLOCK) {
+        int m = (len - i < AMDF_BLOCK) ? len - i : AMDF_BLOCK;
+        sum += frame_abs_diff_i16(x + i, x + i + lag, m);
+        if (sum >= bound) break;
+    }
+    return sum;
+}
+
+// Average Magnitude Difference Function on 16-bit PCM, no FFT. Lags for
+// min_freq..max_freq are compared over the same len = n - max_lag samples.
+// A coarse pass over about AMDF_COARSE_STEPS lags, refined around each
+// dip, stops at the first clear one (which is also what keeps it off
+// multiples of the period). *clarity is 1 - AMDF(period) / mean.
+double detect_pitch_amdf(const int16_t* x, int n, double sample_rate, double min_freq, double max_freq,
+                         double* clarity) {
+    int min_lag = (int)(sample_rate / max_freq);
+    int max_lag = (int)(sample_rate / min_freq);
+    if (min_lag < 2) min_lag = 2;
+    if (max_lag > n / 2) max_lag = n / 2;
+    if (clarity) *clarity = 0;
+    if (max_lag <= min_lag + 1) return 0;
+    int len = n - max_lag - 1;
+
+    // Coarse steps must stay well inside the shortest period to catch its dip
+    int step = (max_lag - min_lag) / AMDF_COARSE_STEPS;
+    if (step > min_lag / 4) step = min_lag / 4;
+    if (step < 1) step = 1;
+
+    // Coarse pass, in increasing lag order, starting one step early so a dip
+    // at min_lag is interior too. Only interior local minima count: at
+    // short lags the AMDF of a low note is still rising from zero. Each one
+    // is refined right away, every lag around it with sums abandoned once
+    // they exceed the dip; the first refined dip well under the mean so
+    // far ends the scan.
+    double mean = 0;
+    int evaluated = 0;
+    uint64_t prev = UINT64_MAX, prev2 = UINT64_MAX;
+    uint64_t best = UINT64_MAX;
+    int best_lag = 0;
+    for (int lag = min_lag - step; lag <= max_lag; lag += step) {
+        uint64_t v = amdf_sum(x, len, lag, UINT64_MAX);
+        mean += (double)v;
+        evaluated++;
+        if (prev2 != UINT64_MAX && prev < prev2 && prev <= v) {
+            int center = lag - step;
+            int lo = (center - step + 1 > min_lag) ? center - step + 1 : min_lag;
+            int hi = (center + step - 1 < max_lag) ? center + step - 1 : max_lag;
+            uint64_t dip = prev;
+            int dip_lag = center;
+            for (int l = lo; l <= hi; l++) {
+                if (l == center) continue;
+                uint64_t d = amdf_sum(x, len, l, dip);
+                if (d < dip) {
+                    dip = d;
+                    dip_lag = l;
+                }
+            }
+            if (dip < best) {
+                best = dip;
+                best_lag = dip_lag;
+            }
+            if (dip < AMDF_DIP * mean / evaluated) break;
+        }
+        prev2 = prev;
+        prev = v;
+    }
+    mean /= evaluated;
+    if (best_lag == 0 || mean <= 0) return 0;
+
+    // Parabolic interpolation of the dip (the neighbours may have been cut short)
+    double delta = 0;
+    if (best_lag > min_lag && best_lag < max_lag) {
+        double y1 = (double)amdf_sum(x, len, best_lag - 1, UINT64_MAX);
+        double y2 = (double)best;
+        double y3 = (double)amdf_sum(x, len, best_lag + 1, UINT64_MAX);
+        double denom = y1 - 2 * y2 + y3;
+        if (denom > 0) delta = 0.5 * (y1 - y3) / denom;
+        if (delta > 1) delta = 1;
+        if (delta < -1) delta = -1;
+    }
+    if (clarity) {
+        *clarity = 1.0 - (double)best / mean;
+        if (*clarity < 0) *clarity = 0;
+    }
+    return sample_rate / (best_lag + delta);
+}
+
+// Real cepstrum from an existing forward spectrum of a real frame. The log
+// magnitude L[k] is real and even, so instead of an n-point inverse FFT the
+// even and odd samples are packed into one n/2-point complex sequence,
+// z[m] = L[2m] + i L[2m+1], and separated after the transform:
+//   C[q] = E[q] + e^{2 pi i q / n} O[q],
+//   E[q] = (Z[q] + conj(Z[n/2 - q])) / 2,  O[q] = (Z[q] - conj(Z[n/2 - q])) / 2i
+// The pitch period is the largest cepstral peak between 1 ms and 12.5 ms
+// (80-1000 Hz). A strong second harmonic moves the spectral peak an octave
+// up but leaves the harmonic spacing, and with it the cepstral peak, alone.
+double detect_pitch_cepstrum(complex_t* spectrum, int n, double sample_rate) {
+    int half = n / 2;
+    double* magnitude = (double*)fft_malloc((half + 1) * sizeof(double));
+    complex_t* packed = allocate_complex_array(half);
+    CHECK_NULL(magnitude, "Failed to allocate magnitude array");
+    STATS_BEGIN(span);
+    frame_magnitude(spectrum, half + 1, magnitude);
+    STATS_END(STATS_MAGNITUDE, span);
+
+    // Bins above n/2 mirror the lower half; the floor keeps log() finite
+    for (int k = 0; k <= half; k++) {
+        magnitude[k] = log(magnitude[k] + 1e-9);
+    }
+    for (int m = 0; m < half; m++) {
+        int even = 2 * m;
+        int odd = 2 * m + 1;
+        packed[m] = magnitude[even <= half ? even : n - even] + I * magnitude[odd <= half ? odd : n - odd];
+    }
+    radix2_dit_fft(packed, half, FFT_INVERSE);
+
+    int min_q = (int)(sample_rate / 1000);  // 1000 Hz max
+    int max_q = (int)(sample_rate / 80);    // 80 Hz min
+    if (min_q < 2) min_q = 2;
+    if (max_q > half - 2) max_q = half - 2;
+
+    double* cepstrum = magnitude;   // log magnitude is no longer needed
+    for (int q = min_q - 1; q <= max_q + 1; q++) {
+        complex_t z = packed[q];
+        complex_t zr = conj(packed[(half - q) % half]);
+        complex_t even = 0.5 * (z + zr);
+        complex_t odd = -0.5 * I * (z - zr);
+        // The half-size inverse scales by 2/n instead of 1/n
+        cepstrum[q] = 0.5 * creal(even + cexp(I * TWO_PI * q / n) * odd);
+    }
+
+    double max_c = 0;
+    int peak_q = 0;
+    for (int q = min_q; q <= max_q; q++) {
+        if (cepstrum[q] > max_c) {
+            max_c = cepstrum[q];
+            peak_q = q;
+        }
+    }
+
+    double pitch = 0;
+    if (peak_q > 0) {
+        // Parabolic interpolation of the peak
+        double y1 = cepstrum[peak_q - 1];
+        double y2 = cepstrum[peak_q];
+        double y3 = cepstrum[peak_q + 1];
+        double denom = y1 - 2 * y2 + y3;
+        double delta = (denom != 0) ? 0.5 * (y1 - y3) / denom : 0;
+        pitch = sample_rate / (peak_q + delta);
+    }
+
+    free_complex_array(packed);
+    fft_free(magnitude);
+    return pitch;
+}
+
+// Harmonic matching on a sparse peak list (spectral_peaks.h). Each peak
+// divided by 1..harmonics proposes a fundamental in 80-1000 Hz; a proposal
+// scores the magnitude of every peak within 50 cents of one of its
+// harmonics, harmonic m weighted by 1/sqrt(m) so that subharmonics, which
+// explain the same peaks at higher m, lose. The winner is refined by the
+// weighted mean of peak / m over its matched peaks. *salience is the share
+// of the total peak magnitude the winner explains.
+double detect_pitch_harmonic_peaks(const peak_t* peaks, int count, int harmonics, double* salience) {
+    double total = 0;
+    for (int i = 0; i < count; i++) total += peaks[i].magnitude;
+
+    double best_score = 0;
+    double best_f0 = 0;
+    for (int i = 0; i < count; i++) {
+        for (int h = 1; h <= harmonics; h++) {
+            double f0 = peaks[i].frequency / h;
+            if (f0 < 80 || f0 > 1000) continue;
+
+            double score = 0;
+            double weighted = 0;
+            for (int p = 0; p < count; p++) {
+                int m = (int)floor(peaks[p].frequency / f0 + 0.5);
+                if (m < 1 || m > harmonics) continue;
+                if (fabs(1200 * log2(peaks[p].frequency / (m * f0))) > 50) continue;
+                double w = peaks[p].magnitude / sqrt(m);
+                score += w;
+                weighted += w * peaks[p].frequency / m;
+            }
+            if (score > best_score) {
+                best_score = score;
+                best_f0 = weighted / score;
+            }
+        }
+    }
+
+    if (salience) {
+        *salience = (total > 0) ? best_score / total : 0;
+        if (*salience > 1) *salience = 1;
+    }
+    return best_f0;
+}
+
+// Run the per-frame detectors over spectra produced by fft_many
+void detect_pitch_peak_many(const complex_t* spectra, int n, int batch, double sample_rate, double* pitches) {
+    complex_t* frame = allocate_complex_array(n);
+    CHECK_NULL(frame, "Failed to allocate frame");
+    for (int b = 0; b < batch; b++) {
+        fft_many_extract(spectra, n, batch, b, frame);
+        pitches[b] = detect_pitch_peak(frame, n, sample_rate);
+    }
+    free_complex_array(frame);
+}
+
+void detect_pitch_hps_many(const complex_t* spectra, int n, int batch, double sample_rate, int harmonics, double* pitches) {
+    complex_t* frame = allocate_complex_array(n);
+    CHECK_NULL(frame, "Failed to allocate frame");
+    for (int b = 0; b < batch; b++) {
+        fft_many_extract(spectra, n, batch, b, frame);
+        pitches[b] = detect_pitch_hps(frame, n, sample_rate, harmonics);
+    }
+    free_complex_array(frame);
+}
+
+// Confidence from agreement between independent estimates (1 = identical)
+static double agreement_confidence(const double* pitches, int count) {
+    double avg_pitch = 0;
+    for (int i = 0; i < count; i++) {
+        avg_pitch += pitches[i];
+    }
+    avg_pitch /= count;
+    if (avg_pitch <= 0) return 0;
+
+    double variance = 0;
+    for (int i = 0; i < count; i++) {
+        variance += pow(pitches[i] - avg_pitch, 2);
+    }
+    variance /= count;
+
+    return 1.0 / (1.0 + sqrt(variance) / avg_pitch);
+}
+
 pitch_result_t detect_pitch_with_confidence(complex_t* signal, int n, double sample_rate) {
     pitch_result_t result = {0};
     
@@ -207,13 +620,8 @@ pitch_result_t detect_pitch_with_confidence(complex_t* signal, int n, double sam
     result.frequency = pitch2;  // HPS is often most reliable
     
     // Estimate confidence based on agreement between methods
-    double avg_pitch = (pitch1 + pitch2 + pitch3) / 3;
-    double variance = pow(pitch1 - avg_pitch, 2) + 
-                     pow(pitch2 - avg_pitch, 2) + 
-                     pow(pitch3 - avg_pitch, 2);
-    variance /= 3;
-    
-    result.confidence = 1.0 / (1.0 + sqrt(variance) / avg_pitch);
+    double pitches[3] = {pitch1, pitch2, pitch3};
+    result.confidence = agreement_confidence(pitches, 3);
     
     // Find musical note
     result.note = frequency_to_note_name(result.frequency);
@@ -223,6 +631,207 @@ pitch_result_t detect_pitch_with_confidence(complex_t* signal, int n, double sam
     return result;
 }
 
+cascade_config_t cascade_default_config(void) {
+    cascade_config_t config;
+    config.silence_rms = 50.0;           // ~ -56 dBFS on 16-bit samples
+    config.confidence_threshold = 0.99;  // estimates within ~2% of each other
+    config.hps_harmonics = 5;
+    return config;
+}
+
+// Pitch from zero crossings of the real part (two crossings per period)
+static double estimate_pitch_zero_crossing(complex_t* signal, int n, double sample_rate) {
+    int crossings = 0;
+    for (int i = 1; i < n; i++) {
+        if ((creal(signal[i - 1]) < 0) != (creal(signal[i]) < 0)) {
+            crossings++;
+        }
+    }
+    return crossings * sample_rate / (2.0 * n);
+}
+
+// Average Magnitude Difference Function on a decimated copy of the frame.
+// Returns the pitch and stores the depth of the chosen dip (0..1) in clarity;
+// clarity is 0 when the dip is ambiguous (see below).
+#define CASCADE_AMDF_DECIMATION 4
+#define CASCADE_MIN_CLARITY 0.5
+
+// Accepted zero-crossing rate relative to the AMDF pitch
+#define CASCADE_ZC_MIN_RATIO 0.9
+#define CASCADE_ZC_MAX_RATIO 3.0
+
+static double amdf_at(const double* x, int m, int lag) {
+    double sum = 0;
+    for (int i = 0; i < m - lag; i++) {
+        sum += fabs(x[i] - x[i + lag]);
+    }
+    return sum / (m - lag);
+}
+
+static double estimate_pitch_amdf_decimated(complex_t* signal, int n, double sample_rate,
+                                            double* clarity) {
+    int m = n / CASCADE_AMDF_DECIMATION;
+    double rate = sample_rate / CASCADE_AMDF_DECIMATION;
+    double* x = (double*)fft_malloc(m * sizeof(double));
+    CHECK_NULL(x, "Failed to allocate AMDF buffer");
+
+    for (int i = 0; i < m; i++) {
+        x[i] = creal(signal[i * CASCADE_AMDF_DECIMATION]);
+    }
+
+    int min_lag = (int)(rate / 1000);  // 1000 Hz max
+    int max_lag = (int)(rate / 80);    // 80 Hz min
+    if (min_lag < 1) min_lag = 1;
+    if (max_lag > m / 2) max_lag = m / 2;
+
+    *clarity = 0;
+    if (max_lag <= min_lag + 1) {
+        fft_free(x);
+        return 0;
+    }
+
+    // One lag either side of the range, so that dips on its edges have both
+    // neighbours
+    double* amdf = (double*)fft_malloc((max_lag + 2) * sizeof(double));
+    CHECK_NULL(amdf, "Failed to allocate AMDF buffer");
+
+    double mean = 0;
+    for (int lag = min_lag - 1; lag <= max_lag + 1; lag++) {
+        amdf[lag] = amdf_at(x, m, lag);
+        if (lag >= min_lag && lag <= max_lag) mean += amdf[lag];
+    }
+    mean /= (max_lag - min_lag + 1);
+
+    // The global minimum may sit on a multiple of the period; take the first
+    // dip that comes close to it instead
+    double global_min = amdf[min_lag];
+    for (int lag = min_lag; lag <= max_lag; lag++) {
+        if (amdf[lag] < global_min) global_min = amdf[lag];
+    }
+
+    int best_lag = 0;
+    double dip_limit = global_min + 0.1 * (mean - global_min);
+    for (int lag = min_lag; lag <= max_lag; lag++) {
+        if (amdf[lag] <= dip_limit &&
+            amdf[lag] <= amdf[lag - 1] && amdf[lag] <= amdf[lag + 1]) {
+            best_lag = lag;
+            break;
+        }
+    }
+
+    double pitch = 0;
+    if (best_lag > 0 && mean > 0) {
+        // Parabolic interpolation of the dip
+        double y1 = amdf[best_lag - 1];
+        double y2 = amdf[best_lag];
+        double y3 = amdf[best_lag + 1];
+        double denom = y1 - 2 * y2 + y3;
+        double delta = (denom != 0) ? 0.5 * (y1 - y3) / denom : 0;
+
+        pitch = rate / (best_lag + delta);
+        *clarity = 1.0 - amdf[best_lag] / mean;
+        if (*clarity < 0) *clarity = 0;
+
+        // A clear dip at a half or a third of the period (also above the
+        // search range) means the chosen lag may be a multiple of the real
+        // one: an octave or a twelfth too low. Leave those to the spectral
+        // stages.
+        for (int k = 2; k <= 3; k++) {
+            int sub = (int)((best_lag + delta) / k + 0.5);
+            if (sub < 2) break;
+            double d = fmin(amdf_at(x, m, sub - 1), fmin(amdf_at(x, m, sub), amdf_at(x, m, sub + 1)));
+            if (1.0 - d / mean >= CASCADE_MIN_CLARITY) {
+                *clarity = 0;
+                break;
+            }
+        }
+    }
+
+    fft_free(amdf);
+    fft_free(x);
+    return pitch;
+}
+
+pitch_result_t detect_pitch_cascade(complex_t* signal, int n, double sample_rate,
+                                    const cascade_config_t* config, cascade_stage_t* stage) {
+    pitch_result_t result = {0};
+    double threshold = config->confidence_threshold;
+
+    // Stage 0: reject silent frames before any FFT
+    double sum_sq = 0;
+    for (int i = 0; i < n; i++) {
+        double v = creal(signal[i]);
+        sum_sq += v * v;
+    }
+    if (sqrt(sum_sq / n) < config->silence_rms) {
+        *stage = CASCADE_STAGE_SILENT;
+        return result;
+    }
+
+    // Stage 1: cheap time-domain estimators. AMDF on each half of the frame
+    // gives two independent estimates. Harmonics add zero crossings, so the
+    // crossing rate may run up to a few times the pitch; well below the AMDF
+    // pitch means the AMDF locked onto a harmonic, far above it that the
+    // AMDF locked onto a multiple of the period. Any disagreement goes on to
+    // the spectral stages.
+    double clarity1, clarity2;
+    double pitch_zc = estimate_pitch_zero_crossing(signal, n, sample_rate);
+    double halves[2];
+    halves[0] = estimate_pitch_amdf_decimated(signal, n / 2, sample_rate, &clarity1);
+    halves[1] = estimate_pitch_amdf_decimated(signal + n / 2, n / 2, sample_rate, &clarity2);
+    double pitch_amdf = (halves[0] > 0 && halves[1] > 0) ? 0.5 * (halves[0] + halves[1]) : 0;
+
+    result.frequency = pitch_amdf;
+    result.confidence = (pitch_amdf > 0) ? agreement_confidence(halves, 2) : 0;
+    *stage = CASCADE_STAGE_CHEAP;
+    if (pitch_amdf > 0 && result.confidence >= threshold &&
+        clarity1 >= CASCADE_MIN_CLARITY && clarity2 >= CASCADE_MIN_CLARITY &&
+        pitch_zc >= CASCADE_ZC_MIN_RATIO * pitch_amdf && pitch_zc <= CASCADE_ZC_MAX_RATIO * pitch_amdf) {
+        result.note = frequency_to_note_name(result.frequency);
+        return result;
+    }
+
+    // Stage 2: spectral peak, the spectrum is reused by the later stages
+    complex_t* spectrum = allocate_complex_array(n);
+    CHECK_NULL(spectrum, "Failed to allocate spectrum");
+    memcpy(spectrum, signal, n * sizeof(complex_t));
+    radix2_dit_fft(spectrum, n, FFT_FORWARD);
+
+    double pitch_peak = detect_pitch_peak(spectrum, n, sample_rate);
+    double spectral[3] = {pitch_amdf, pitch_peak, 0};
+    result.frequency = pitch_peak;
+    result.confidence = (pitch_amdf > 0) ? agreement_confidence(spectral, 2) : 0;
+    *stage = CASCADE_STAGE_PEAK;
+    if (result.confidence >= threshold) {
+        goto DONE;
+    }
+
+    // Stage 3: HPS
+    double pitch_hps = detect_pitch_hps(spectrum, n, sample_rate, config->hps_harmonics);
+    spectral[2] = pitch_hps;
+    result.frequency = pitch_hps;
+    result.confidence = (pitch_amdf > 0) ? agreement_confidence(spectral, 3)
+                                         : agreement_confidence(spectral + 1, 2);
+    *stage = CASCADE_STAGE_HPS;
+    if (result.confidence >= threshold) {
+        goto DONE;
+    }
+
+    // Stage 4: autocorrelation, combined as in detect_pitch_with_confidence
+    double pitch_autocorr = detect_pitch_autocorr(signal, n, sample_rate);
+    double all[3] = {pitch_peak, pitch_hps, pitch_autocorr};
+    result.frequency = pitch_hps;
+    result.confidence = agreement_confidence(all, 3);
+    *stage = CASCADE_STAGE_AUTOCORR;
+
+DONE:
+    free_complex_array(spectrum);
+    if (result.frequency > 0) {
+        result.note = frequency_to_note_name(result.frequency);
+    }
+    return result;
+}
+
 // Generate test signals
 void generate_musical_note(complex_t* signal, int n, double freq, double sample_rate, 
                           int num_harmonics, double* harmonic_amps) {
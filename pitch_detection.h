@@ -25,6 +25,7 @@
 
 #include "fft_common.h"
 #include "fft_algorithms.h"
+#include "audio_spectrum.h"
 
 // Musical note frequencies (A4 = 440 Hz)
 typedef struct {
@@ -32,6 +33,9 @@ typedef struct {
     double frequency;
 } musical_note_t;
 
+extern musical_note_t notes[];
+extern int num_notes;
+
 // Pitch detection with confidence estimation
 typedef struct {
     double frequency;
@@ -40,14 +44,60 @@ typedef struct {
     double cents_off;
 } pitch_result_t;
 
+// Cascade detector: cheap estimators first, escalating to the spectral
+// methods only while the confidence stays under the threshold
+typedef enum {
+    CASCADE_STAGE_SILENT = 0,
+    CASCADE_STAGE_CHEAP,
+    CASCADE_STAGE_PEAK,
+    CASCADE_STAGE_HPS,
+    CASCADE_STAGE_AUTOCORR,
+    CASCADE_STAGE_COUNT
+} cascade_stage_t;
+
+typedef struct {
+    double silence_rms;            // frames below this RMS are skipped without an FFT
+    double confidence_threshold;   // stop escalating once confidence reaches this
+    int hps_harmonics;
+} cascade_config_t;
+
+int frequency_to_note(double freq, double* cents);
+const char* note_name(int idx);
+// Phase vocoder state: phases of the previous frame, `hop` samples earlier
+typedef struct {
+    int n;
+    int hop;
+    double sample_rate;
+    double* prev_phase;
+    int has_prev;
+} phase_vocoder_t;
+
 const char* frequency_to_note_name(double freq);
 double detect_pitch_peak(complex_t* spectrum, int n, double sample_rate);
+double detect_pitch_peak_magnitude(const double* magnitude, int n, double sample_rate);
+double detect_pitch_peak_q15(const cq15_t* spectrum, int n, double sample_rate);
+double detect_pitch_zoom(complex_t* signal, int n, double sample_rate, double coarse_freq,
+                         double span_bins, int points, double* magnitude);
+phase_vocoder_t* phase_vocoder_create(int n, int hop, double sample_rate);
+void phase_vocoder_free(phase_vocoder_t* pv);
+void phase_vocoder_reset(phase_vocoder_t* pv);
+double phase_vocoder_frequency(const phase_vocoder_t* pv, const double* phase, int bin);
+double detect_pitch_phase_vocoder(phase_vocoder_t* pv, complex_t* spectrum);
 double detect_pitch_hps(complex_t* spectrum, int n, double sample_rate, int harmonics);
 double detect_pitch_autocorr(complex_t* signal, int n, double sample_rate);
+double detect_pitch_amdf(const int16_t* x, int n, double sample_rate, double min_freq, double max_freq,
+                         double* clarity);
+double detect_pitch_cepstrum(complex_t* spectrum, int n, double sample_rate);
+double detect_pitch_harmonic_peaks(const peak_t* peaks, int count, int harmonics, double* salience);
 double detect_pitch_peak_v2(complex_t* spectrum, int n, double *fundamentals);
 double detect_pitch_hps_v2(complex_t* spectrum, int n, double sample_rate, int harmonics);
 double detect_pitch_autocorr_v2(complex_t* signal, int n, double sample_rate);
+void detect_pitch_peak_many(const complex_t* spectra, int n, int batch, double sample_rate, double* pitches);
+void detect_pitch_hps_many(const complex_t* spectra, int n, int batch, double sample_rate, int harmonics, double* pitches);
 pitch_result_t detect_pitch_with_confidence(complex_t* signal, int n, double sample_rate);
+cascade_config_t cascade_default_config(void);
+pitch_result_t detect_pitch_cascade(complex_t* signal, int n, double sample_rate,
+                                    const cascade_config_t* config, cascade_stage_t* stage);
 void generate_musical_note(complex_t* signal, int n, double freq, double sample_rate, int num_harmonics, double* harmonic_amps);
 
 #endif
\ No newline at end of file
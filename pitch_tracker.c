@@ -0,0 +1,284 @@
+#include "pitch_tracker.h"
+
+// Emission probabilities never go below this, so a state the detectors
+// disagree with is expensive but not impossible
+#define PITCH_TRACKER_FLOOR 1e-3
+
+// Semitone changes beyond an octave cost the same as an octave
+#define PITCH_TRACKER_MAX_JUMP 12
+
+struct pitch_tracker {
+    pitch_tracker_config_t config;
+    pitch_track_fn emit;
+    void* ctx;
+
+    int base;           // semitone of state 0, relative to A4
+    int voiced;         // semitone states; state `voiced` is unvoiced
+    int states;
+    int slots;          // lag + 1 frames of history
+
+    double* score;      // log score of the best path into each state
+    double* next;
+    double* emission;
+    int* beam;          // states of the previous frame that are extended
+    int* backptr;       // slot s, state j at [s * states + j]: state one frame earlier
+    int* path;          // flush scratch, one state per slot
+
+    uint32_t* frames;   // per slot: frame number, timestamp and candidates
+    double* timestamps;
+    pitch_candidate_t* candidates;
+    int* counts;
+
+    uint64_t pushed;
+    uint64_t emitted;
+};
+
+pitch_tracker_config_t pitch_tracker_default_config(void) {
+    pitch_tracker_config_t config;
+    config.min_freq = 55.0;
+    config.max_freq = 1760.0;
+    config.lag = 8;
+    config.beam = 16;
+    config.sigma_cents = 35.0;
+    config.octave_weight = 0.3;
+    config.change_cost = 2.0;
+    config.jump_cost = 0.25;
+    config.voicing_cost = 3.0;
+    return config;
+}
+
+pitch_tracker_t* pitch_tracker_create(const pitch_tracker_config_t* config, pitch_track_fn emit, void* ctx) {
+    pitch_tracker_t* t = (pitch_tracker_t*)fft_calloc(1, sizeof(pitch_tracker_t));
+    CHECK_NULL(t, "Failed to allocate pitch tracker");
+    t->config = *config;
+    if (t->config.lag < 0) t->config.lag = 0;
+    t->emit = emit;
+    t->ctx = ctx;
+    t->base = (int)floor(12 * log2(config->min_freq / 440.0) + 0.5);
+    int top = (int)floor(12 * log2(config->max_freq / 440.0) + 0.5);
+    t->voiced = (top >= t->base) ? top - t->base + 1 : 1;
+    t->states = t->voiced + 1;
+    if (t->config.beam < 1 || t->config.beam > t->states) t->config.beam = t->states;
+    t->slots = t->config.lag + 1;
+
+    t->score = (double*)fft_malloc(t->states * sizeof(double));
+    t->next = (double*)fft_malloc(t->states * sizeof(double));
+    t->emission = (double*)fft_malloc(t->states * sizeof(double));
+    t->beam = (int*)fft_malloc(t->config.beam * sizeof(int));
+    t->backptr = (int*)fft_malloc((size_t)t->slots * t->states * sizeof(int));
+    t->path = (int*)fft_malloc(t->slots * sizeof(int));
+    t->frames = (uint32_t*)fft_malloc(t->slots * sizeof(uint32_t));
+    t->timestamps = (double*)fft_malloc(t->slots * sizeof(double));
+    t->candidates = (pitch_candidate_t*)fft_malloc((size_t)t->slots * PITCH_TRACKER_MAX_CANDIDATES *
+                                                   sizeof(pitch_candidate_t));
+    t->counts = (int*)fft_malloc(t->slots * sizeof(int));
+    CHECK_NULL(t->score, "Failed to allocate tracker scores");
+    CHECK_NULL(t->next, "Failed to allocate tracker scores");
+    CHECK_NULL(t->emission, "Failed to allocate tracker scores");
+    CHECK_NULL(t->beam, "Failed to allocate tracker beam");
+    CHECK_NULL(t->backptr, "Failed to allocate tracker history");
+    CHECK_NULL(t->path, "Failed to allocate tracker history");
+    CHECK_NULL(t->frames, "Failed to allocate tracker history");
+    CHECK_NULL(t->timestamps, "Failed to allocate tracker history");
+    CHECK_NULL(t->candidates, "Failed to allocate tracker history");
+    CHECK_NULL(t->counts, "Failed to allocate tracker history");
+    return t;
+}
+
+void pitch_tracker_free(pitch_tracker_t* t) {
+    if (t == NULL) return;
+    fft_free(t->counts);
+    fft_free(t->candidates);
+    fft_free(t->timestamps);
+    fft_free(t->frames);
+    fft_free(t->path);
+    fft_free(t->backptr);
+    fft_free(t->beam);
+    fft_free(t->emission);
+    fft_free(t->next);
+    fft_free(t->score);
+    fft_free(t);
+}
+
+static double candidate_weight(const pitch_candidate_t* c) {
+    if (isnan(c->confidence)) return 1.0;
+    if (c->confidence < 0) return 0.0;
+    return c->confidence > 1 ? 1.0 : c->confidence;
+}
+
+// Log emission of every state for one frame's candidates
+static void compute_emission(pitch_tracker_t* t, const pitch_candidate_t* candidates, int count) {
+    double sigma = t->config.sigma_cents;
+    double strongest = 0;
+    for (int j = 0; j < t->voiced; j++) t->emission[j] = 0;
+
+    for (int c = 0; c < count; c++) {
+        if (candidates[c].frequency <= 0) continue;
+        double w = candidate_weight(&candidates[c]);
+        if (w > strongest) strongest = w;
+        double cents = 1200 * log2(candidates[c].frequency / 440.0);
+        for (int j = 0; j < t->voiced; j++) {
+            double d = (cents - 100.0 * (t->base + j)) / sigma;
+            double up = d - 1200.0 / sigma;
+            double down = d + 1200.0 / sigma;
+            t->emission[j] += w * (exp(-0.5 * d * d) +
+                                   t->config.octave_weight * (exp(-0.5 * up * up) + exp(-0.5 * down * down)));
+        }
+    }
+    for (int j = 0; j < t->voiced; j++) {
+        t->emission[j] = log(PITCH_TRACKER_FLOOR + t->emission[j]);
+    }
+    t->emission[t->voiced] = log(PITCH_TRACKER_FLOOR + 1.0 - strongest);
+}
+
+static double transition(const pitch_tracker_t* t, int from, int to) {
+    if (from == to) return 0;
+    if (from == t->voiced || to == t->voiced) return -t->config.voicing_cost;
+    int jump = abs(to - from);
+    if (jump > PITCH_TRACKER_MAX_JUMP) jump = PITCH_TRACKER_MAX_JUMP;
+    return -(t->config.change_cost + t->config.jump_cost * jump);
+}
+
+static void beam_sift_down(const double* score, int* heap, int count, int i) {
+    for (;;) {
+        int smallest = i;
+        int l = 2 * i + 1;
+        int r = l + 1;
+        if (l < count && score[heap[l]] < score[heap[smallest]]) smallest = l;
+        if (r < count && score[heap[r]] < score[heap[smallest]]) smallest = r;
+        if (smallest == i) return;
+        int tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+// Indices of the `beam` highest scores, kept in a min-heap on score
+static int select_beam(pitch_tracker_t* t) {
+    int beam = t->config.beam;
+    int count = 0;
+    for (int i = 0; i < t->states; i++) {
+        if (count < beam) {
+            t->beam[count] = i;
+            int c = count++;
+            while (c > 0 && t->score[t->beam[(c - 1) / 2]] > t->score[t->beam[c]]) {
+                int parent = (c - 1) / 2;
+                int tmp = t->beam[parent];
+                t->beam[parent] = t->beam[c];
+                t->beam[c] = tmp;
+                c = parent;
+            }
+        }
+        else if (t->score[i] > t->score[t->beam[0]]) {
+            t->beam[0] = i;
+            beam_sift_down(t->score, t->beam, count, 0);
+        }
+    }
+    return count;
+}
+
+static int best_state(const pitch_tracker_t* t) {
+    int best = 0;
+    for (int j = 1; j < t->states; j++) {
+        if (t->score[j] > t->score[best]) best = j;
+    }
+    return best;
+}
+
+// Report a decided frame: the candidate (moved by up to an octave) that
+// lies on the decoded semitone, or the semitone itself
+static void emit_state(pitch_tracker_t* t, uint64_t index, int state) {
+    int slot = (int)(index % t->slots);
+    pitch_track_point_t point;
+    point.frame = t->frames[slot];
+    point.timestamp = t->timestamps[slot];
+    point.frequency = 0;
+    point.confidence = NAN;
+    if (state != t->voiced) {
+        double target = 100.0 * (t->base + state);
+        double best = 100.0;
+        point.frequency = 440.0 * pow(2, (t->base + state) / 12.0);
+        const pitch_candidate_t* candidates = t->candidates + (size_t)slot * PITCH_TRACKER_MAX_CANDIDATES;
+        for (int c = 0; c < t->counts[slot]; c++) {
+            if (candidates[c].frequency <= 0) continue;
+            double cents = 1200 * log2(candidates[c].frequency / 440.0);
+            for (int octave = -1; octave <= 1; octave++) {
+                double d = fabs(cents + 1200.0 * octave - target);
+                if (d < best) {
+                    best = d;
+                    point.frequency = candidates[c].frequency * pow(2, octave);
+                    point.confidence = candidates[c].confidence;
+                }
+            }
+        }
+    }
+    t->emit(&point, t->ctx);
+    t->emitted++;
+}
+
+void pitch_tracker_push(pitch_tracker_t* t, uint32_t frame, double timestamp,
+                        const pitch_candidate_t* candidates, int count) {
+    if (count > PITCH_TRACKER_MAX_CANDIDATES) count = PITCH_TRACKER_MAX_CANDIDATES;
+    int slot = (int)(t->pushed % t->slots);
+    t->frames[slot] = frame;
+    t->timestamps[slot] = timestamp;
+    t->counts[slot] = count;
+    memcpy(t->candidates + (size_t)slot * PITCH_TRACKER_MAX_CANDIDATES, candidates,
+           count * sizeof(pitch_candidate_t));
+
+    compute_emission(t, candidates, count);
+    int* backptr = t->backptr + (size_t)slot * t->states;
+    if (t->pushed == 0) {
+        for (int j = 0; j < t->states; j++) {
+            t->score[j] = t->emission[j];
+            backptr[j] = j;
+        }
+    }
+    else {
+        int kept = select_beam(t);
+        double top = -INFINITY;
+        for (int j = 0; j < t->states; j++) {
+            double best = -INFINITY;
+            int from = t->beam[0];
+            for (int b = 0; b < kept; b++) {
+                int i = t->beam[b];
+                double v = t->score[i] + transition(t, i, j);
+                if (v > best) {
+                    best = v;
+                    from = i;
+                }
+            }
+            t->next[j] = best + t->emission[j];
+            backptr[j] = from;
+            if (t->next[j] > top) top = t->next[j];
+        }
+        // Keep the scores near zero on long streams
+        for (int j = 0; j < t->states; j++) t->next[j] -= top;
+        double* tmp = t->score;
+        t->score = t->next;
+        t->next = tmp;
+    }
+    t->pushed++;
+
+    if (t->pushed > (uint64_t)t->config.lag) {
+        int state = best_state(t);
+        for (uint64_t i = t->pushed - 1; i > t->pushed - 1 - t->config.lag; i--) {
+            state = t->backptr[(size_t)(i % t->slots) * t->states + state];
+        }
+        emit_state(t, t->pushed - 1 - t->config.lag, state);
+    }
+}
+
+void pitch_tracker_flush(pitch_tracker_t* t) {
+    if (t->emitted == t->pushed) return;
+    int state = best_state(t);
+    for (uint64_t i = t->pushed - 1;; i--) {
+        t->path[i % t->slots] = state;
+        if (i == t->emitted) break;
+        state = t->backptr[(size_t)(i % t->slots) * t->states + state];
+    }
+    while (t->emitted < t->pushed) {
+        emit_state(t, t->emitted, t->path[t->emitted % t->slots]);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef PITCH_TRACKER_H
+#define PITCH_TRACKER_H
+
+#include <stdint.h>
+#include "fft_common.h"
+
+// Online pitch tracking over semitone states. Each frame's detector output
+// (one or more candidate pitches with confidences) is scored against every
+// semitone between min_freq and max_freq plus an unvoiced state, and a
+// Viterbi pass with transition costs for note changes and voicing changes
+// picks a smooth path. Decoding is fixed-lag: frame t is decided once
+// frame t + lag has been seen, by backtracking from the best state at that
+// point, so output trails the input by `lag` frames. Only the `beam` best
+// states of a frame are extended to the next one. Per-frame work is
+// O(beam * states + lag) and memory is O(lag * states) however long the
+// stream runs.
+
+#define PITCH_TRACKER_MAX_CANDIDATES 4
+
+typedef struct {
+    double min_freq;        // lowest and highest tracked semitone (Hz)
+    double max_freq;
+    int lag;                // frames between input and final decision
+    int beam;               // states extended per frame
+    double sigma_cents;     // spread of a candidate around its semitone
+    double octave_weight;   // evidence a candidate gives one octave up and down
+    double change_cost;     // log cost of any note change
+    double jump_cost;       // extra log cost per semitone of the change
+    double voicing_cost;    // log cost of switching between voiced and unvoiced
+} pitch_tracker_config_t;
+
+typedef struct {
+    double frequency;       // Hz, 0 for no pitch
+    double confidence;      // 0..1, NAN when the detector has none
+} pitch_candidate_t;
+
+// One decided frame; frequency is 0 when the path is unvoiced
+typedef struct {
+    uint32_t frame;
+    double timestamp;
+    double frequency;
+    double confidence;
+} pitch_track_point_t;
+
+typedef void (*pitch_track_fn)(const pitch_track_point_t* point, void* ctx);
+
+typedef struct pitch_tracker pitch_tracker_t;
+
+pitch_tracker_config_t pitch_tracker_default_config(void);
+pitch_tracker_t* pitch_tracker_create(const pitch_tracker_config_t* config, pitch_track_fn emit, void* ctx);
+// Add a frame; emits the frame `lag` frames back once it is decided
+void pitch_tracker_push(pitch_tracker_t* tracker, uint32_t frame, double timestamp,
+                        const pitch_candidate_t* candidates, int count);
+// Decide and emit the frames still within the lag (end of stream)
+void pitch_tracker_flush(pitch_tracker_t* tracker);
+void pitch_tracker_free(pitch_tracker_t* tracker);
+
+#endif
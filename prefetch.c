@@ -0,0 +1,125 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include "prefetch.h"
+
+typedef struct {
+    int index;
+    bool loaded;
+    sound_t sound;
+} prefetch_slot_t;
+
+struct prefetch {
+    const char* const* paths;
+    int count;
+    int depth;
+    size_t max_bytes;
+
+    prefetch_slot_t* slots;     // ring of `depth` entries
+    int head;                   // next slot the consumer takes
+    int queued;
+    size_t queued_bytes;
+    int next_load;              // next path the reader loads
+    int produced;               // recordings queued so far
+    int stop;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static void* reader_thread(void* arg) {
+    prefetch_t* p = (prefetch_t*)arg;
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->stop && p->next_load < p->count) {
+        // Wait for room: a free slot and, unless the queue is empty, budget
+        while (!p->stop && (p->queued == p->depth ||
+                            (p->queued > 0 && p->queued_bytes >= p->max_bytes))) {
+            pthread_cond_wait(&p->cond, &p->lock);
+        }
+        if (p->stop) break;
+        int index = p->next_load++;
+        pthread_mutex_unlock(&p->lock);
+
+        // The blocking read runs without the lock
+        prefetch_slot_t slot;
+        slot.index = index;
+        slot.loaded = LoadWav(p->paths[index], &slot.sound);
+
+        pthread_mutex_lock(&p->lock);
+        p->slots[(p->head + p->queued) % p->depth] = slot;
+        p->queued++;
+        p->produced++;
+        if (slot.loaded) {
+            p->queued_bytes += (size_t)slot.sound.samples * sizeof(int16_t);
+        }
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+prefetch_t* prefetch_open(const char* const* paths, int count, int depth, size_t max_bytes) {
+    prefetch_t* p = calloc(1, sizeof(prefetch_t));
+    if (p == NULL) return NULL;
+    p->paths = paths;
+    p->count = count;
+    p->depth = depth > 0 ? depth : 1;
+    p->max_bytes = max_bytes;
+    p->slots = calloc(p->depth, sizeof(prefetch_slot_t));
+    if (p->slots == NULL) {
+        free(p);
+        return NULL;
+    }
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    if (pthread_create(&p->thread, NULL, reader_thread, p) != 0) {
+        pthread_cond_destroy(&p->cond);
+        pthread_mutex_destroy(&p->lock);
+        free(p->slots);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+bool prefetch_next(prefetch_t* p, int* index, sound_t* sound, bool* loaded) {
+    pthread_mutex_lock(&p->lock);
+    while (p->queued == 0 && p->produced < p->count) {
+        pthread_cond_wait(&p->cond, &p->lock);
+    }
+    if (p->queued == 0) {
+        pthread_mutex_unlock(&p->lock);
+        return false;
+    }
+    prefetch_slot_t* slot = &p->slots[p->head];
+    *index = slot->index;
+    *loaded = slot->loaded;
+    *sound = slot->sound;
+    if (slot->loaded) {
+        p->queued_bytes -= (size_t)slot->sound.samples * sizeof(int16_t);
+    }
+    p->head = (p->head + 1) % p->depth;
+    p->queued--;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    return true;
+}
+
+void prefetch_close(prefetch_t* p) {
+    if (p == NULL) return;
+    pthread_mutex_lock(&p->lock);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+
+    for (int i = 0; i < p->queued; i++) {
+        prefetch_slot_t* slot = &p->slots[(p->head + i) % p->depth];
+        if (slot->loaded) free(slot->sound.data);
+    }
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    free(p->slots);
+    free(p);
+}
@@ -0,0 +1,29 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "wavformat.h"
+
+// Background loading of the next recordings while the current one is
+// analyzed. A reader thread runs LoadWav over a list of paths, in order,
+// into a bounded queue: at most `depth` recordings and `max_bytes` of
+// samples wait at any time (a single larger recording is still let
+// through when the queue is empty, so the run always makes progress).
+
+#define PREFETCH_DEFAULT_DEPTH 2
+#define PREFETCH_MAX_BYTES ((size_t)256 << 20)
+
+typedef struct prefetch prefetch_t;
+
+prefetch_t* prefetch_open(const char* const* paths, int count, int depth, size_t max_bytes);
+
+// Next recording in list order. Returns false once the list is exhausted;
+// otherwise *loaded tells whether LoadWav succeeded, and on success the
+// caller owns sound->data.
+bool prefetch_next(prefetch_t* prefetch, int* index, sound_t* sound, bool* loaded);
+
+// Stop the reader (possibly early) and drop whatever is still queued
+void prefetch_close(prefetch_t* prefetch);
+
+#endif
@@ -0,0 +1,191 @@
+#include "prefilter.h"
+#include "audio_spectrum.h"
+
+// Smallest FFT, so that short filters (pre-emphasis) still move whole
+// blocks per transform
+#define PREFILTER_MIN_FFT 1024
+
+struct prefilter {
+    int taps;
+    int n;              // FFT size
+    int block;          // new samples per FFT, n - taps + 1
+    int delay;          // group delay of the (linear-phase) taps
+    complex_t* response;  // cached FFT of the zero-padded taps
+    complex_t* work;
+    double* history;    // last taps - 1 input samples
+    double* out;        // one block of output, for prefilter_apply
+};
+
+static const char* prefilter_names[PREFILTER_COUNT] = {"none", "bandpass", "highpass", "preemphasis"};
+
+prefilter_config_t prefilter_default_config(void) {
+    prefilter_config_t config;
+    config.type = PREFILTER_NONE;
+    config.low_hz = 40.0;
+    config.high_hz = 5000.0;
+    config.taps = 4095;     // Blackman transition of ~60 Hz at 44.1 kHz
+    config.coefficient = 0.97;
+    return config;
+}
+
+int prefilter_from_name(const char* name) {
+    for (int i = 0; i < PREFILTER_COUNT; i++) {
+        if (strcmp(name, prefilter_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char* prefilter_name(prefilter_type_t type) {
+    if (type < 0 || type >= PREFILTER_COUNT) return "unknown";
+    return prefilter_names[type];
+}
+
+// Windowed-sinc low-pass with cutoff fc (Hz), centred on tap `center`
+static double lowpass_tap(int k, int center, double fc, double sample_rate) {
+    double w = 2.0 * fc / sample_rate;
+    double x = k - center;
+    if (x == 0) return w;
+    return sin(PI * w * x) / (PI * x);
+}
+
+static double* design_taps(const prefilter_config_t* config, double sample_rate, int* taps) {
+    if (config->type == PREFILTER_PREEMPHASIS) {
+        *taps = 2;
+        double* h = (double*)fft_malloc(2 * sizeof(double));
+        CHECK_NULL(h, "Failed to allocate filter taps");
+        h[0] = 1.0;
+        h[1] = -config->coefficient;
+        return h;
+    }
+
+    int m = config->taps | 1;
+    if (m < 3) m = 3;
+    *taps = m;
+    int center = m / 2;
+    double nyquist = sample_rate / 2;
+    double low = fmin(fmax(config->low_hz, 0.0), nyquist);
+    double high = fmin(fmax(config->high_hz, low), nyquist);
+
+    // Low-pass prototypes normalized to unit DC gain, so the high-pass
+    // and band-pass below remove DC exactly however short the filter is
+    double* window = window_table(m, WINDOW_BLACKMAN);
+    double* h = (double*)fft_malloc(m * sizeof(double));
+    double* lp_high = (double*)fft_malloc(m * sizeof(double));
+    CHECK_NULL(h, "Failed to allocate filter taps");
+    CHECK_NULL(lp_high, "Failed to allocate filter taps");
+    double sum_low = 0, sum_high = 0;
+    for (int k = 0; k < m; k++) {
+        h[k] = lowpass_tap(k, center, low, sample_rate) * window[k];
+        lp_high[k] = lowpass_tap(k, center, high, sample_rate) * window[k];
+        sum_low += h[k];
+        sum_high += lp_high[k];
+    }
+    for (int k = 0; k < m; k++) {
+        double lp_low = (sum_low > 0) ? h[k] / sum_low : 0.0;
+        if (config->type == PREFILTER_HIGHPASS) {
+            h[k] = (k == center ? 1.0 : 0.0) - lp_low;
+        } else {
+            h[k] = ((sum_high > 0) ? lp_high[k] / sum_high : 0.0) - lp_low;
+        }
+    }
+    fft_free(lp_high);
+    fft_free(window);
+    return h;
+}
+
+prefilter_t* prefilter_create(const prefilter_config_t* config, double sample_rate) {
+    prefilter_t* f = (prefilter_t*)fft_calloc(1, sizeof(prefilter_t));
+    CHECK_NULL(f, "Failed to allocate prefilter");
+    double* h = design_taps(config, sample_rate, &f->taps);
+    f->delay = (config->type == PREFILTER_PREEMPHASIS) ? 0 : f->taps / 2;
+    f->n = next_power_of_two(4 * f->taps > PREFILTER_MIN_FFT ? 4 * f->taps : PREFILTER_MIN_FFT);
+    f->block = f->n - f->taps + 1;
+
+    // Cached filter spectrum; the inverse transform's 1/n is already in
+    // radix2_dit_fft, so the taps go in as they are
+    f->response = allocate_complex_array(f->n);
+    f->work = allocate_complex_array(f->n);
+    f->history = (double*)fft_calloc(f->taps - 1, sizeof(double));
+    f->out = (double*)fft_malloc(f->block * sizeof(double));
+    CHECK_NULL(f->response, "Failed to allocate filter spectrum");
+    CHECK_NULL(f->work, "Failed to allocate filter buffer");
+    CHECK_NULL(f->history, "Failed to allocate filter history");
+    CHECK_NULL(f->out, "Failed to allocate filter output");
+    for (int k = 0; k < f->taps; k++) f->response[k] = h[k];
+    radix2_dit_fft(f->response, f->n, FFT_FORWARD);
+    fft_free(h);
+    return f;
+}
+
+void prefilter_free(prefilter_t* f) {
+    if (f == NULL) return;
+    fft_free(f->out);
+    fft_free(f->history);
+    free_complex_array(f->work);
+    free_complex_array(f->response);
+    fft_free(f);
+}
+
+int prefilter_block_size(const prefilter_t* f) {
+    return f->block;
+}
+
+int prefilter_delay(const prefilter_t* f) {
+    return f->delay;
+}
+
+void prefilter_block(prefilter_t* f, const int16_t* in, int count, double* out) {
+    int keep = f->taps - 1;
+    if (count > f->block) count = f->block;
+
+    // [history | new samples | zeros]; outputs keep .. keep + count are
+    // free of circular wrap-around
+    for (int i = 0; i < keep; i++) f->work[i] = f->history[i];
+    for (int i = 0; i < count; i++) f->work[keep + i] = (double)in[i];
+    for (int i = keep + count; i < f->n; i++) f->work[i] = 0.0;
+
+    // The next block's history: the last `keep` samples seen so far
+    if (count >= keep) {
+        for (int i = 0; i < keep; i++) f->history[i] = in[count - keep + i];
+    } else {
+        memmove(f->history, f->history + count, (keep - count) * sizeof(double));
+        for (int i = 0; i < count; i++) f->history[keep - count + i] = in[i];
+    }
+
+    radix2_dit_fft(f->work, f->n, FFT_FORWARD);
+    for (int i = 0; i < f->n; i++) f->work[i] *= f->response[i];
+    radix2_dit_fft(f->work, f->n, FFT_INVERSE);
+
+    for (int i = 0; i < count; i++) out[i] = creal(f->work[keep + i]);
+}
+
+void prefilter_apply(prefilter_t* f, int16_t* samples, uint32_t count) {
+    // Output y[k] belongs at k - delay; run delay samples past the end
+    // (reading zeros) so the tail is complete. Each block is copied into
+    // the FFT buffer before any output is written, and outputs land at or
+    // before the block start plus its length, so in-place is safe.
+    uint64_t total = (uint64_t)count + f->delay;
+    int16_t* pad = (int16_t*)fft_calloc(f->block, sizeof(int16_t));
+    CHECK_NULL(pad, "Failed to allocate filter padding");
+
+    for (uint64_t pos = 0; pos < total; pos += f->block) {
+        int len = (total - pos < (uint64_t)f->block) ? (int)(total - pos) : f->block;
+        const int16_t* in = samples + pos;
+        if (pos + len > count) {
+            // Partial or past-the-end block: copy what is left, zeros after
+            int have = (pos < count) ? (int)(count - pos) : 0;
+            memset(pad, 0, len * sizeof(int16_t));
+            if (have > 0) memcpy(pad, samples + pos, have * sizeof(int16_t));
+            in = pad;
+        }
+        prefilter_block(f, in, len, f->out);
+
+        for (int i = 0; i < len; i++) {
+            int64_t target = (int64_t)(pos + i) - f->delay;
+            if (target < 0 || target >= count) continue;
+            double v = round(f->out[i]);
+            samples[target] = (int16_t)fmax(-32768.0, fmin(32767.0, v));
+        }
+    }
+    fft_free(pad);
+}
@@ -0,0 +1,52 @@
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+#include <stdint.h>
+#include "fft_common.h"
+
+// FIR pre-filter applied to the recording as a stream, before it is cut
+// into analysis frames. The filter (windowed-sinc band-pass or high-pass,
+// or first-order pre-emphasis) runs by overlap-save: each block of L new
+// samples is transformed together with the last taps - 1 samples of
+// history, multiplied by the cached spectrum of the taps and transformed
+// back, keeping the L outputs free of wrap-around. With an N-point FFT
+// (4 * taps rounded up to a power of two, at least 1024) that is
+// O(log N) work per sample instead of the O(taps) of a direct-form FIR.
+
+typedef enum {
+    PREFILTER_NONE = 0,
+    PREFILTER_BANDPASS,     // low_hz .. high_hz
+    PREFILTER_HIGHPASS,     // above low_hz
+    PREFILTER_PREEMPHASIS,  // y[k] = x[k] - coefficient * x[k - 1]
+    PREFILTER_COUNT
+} prefilter_type_t;
+
+typedef struct {
+    prefilter_type_t type;
+    double low_hz;
+    double high_hz;
+    int taps;               // odd length of the band-pass / high-pass FIR
+    double coefficient;     // pre-emphasis
+} prefilter_config_t;
+
+typedef struct prefilter prefilter_t;
+
+prefilter_config_t prefilter_default_config(void);
+int prefilter_from_name(const char* name);
+const char* prefilter_name(prefilter_type_t type);
+
+prefilter_t* prefilter_create(const prefilter_config_t* config, double sample_rate);
+void prefilter_free(prefilter_t* filter);
+
+// Stream primitive: filter the next `count` (at most prefilter_block_size)
+// samples into out[0..count). Output is causal, delayed by
+// prefilter_delay() samples against the input.
+int prefilter_block_size(const prefilter_t* filter);
+int prefilter_delay(const prefilter_t* filter);
+void prefilter_block(prefilter_t* filter, const int16_t* in, int count, double* out);
+
+// Filter a whole recording in place, block by block, delay compensated
+// and saturated back to 16 bits
+void prefilter_apply(prefilter_t* filter, int16_t* samples, uint32_t count);
+
+#endif
@@ -52,6 +52,12 @@
  * 3. Execute log₂(n) stages of butterfly operations
  * 4. Scale output for inverse transform
  * 
+ * The engine selected with fft_set_engine() (see fft_engine.c) decides
+ * whether this loop runs with the plain or the cache-blocked (COBRA)
+ * bit-reversal, or whether the transform goes to the Stockham, the
+ * six-step engine or a size-specialized codelet (sizes without a codelet
+ * fall back to this loop).
+ * 
  * @param x Input/output array of complex numbers
  * @param n Length of array (must be power of 2)
  * @param dir Transform direction (FFT_FORWARD or FFT_INVERSE)
@@ -60,6 +66,19 @@ void radix2_dit_fft(complex_t* x, int n, fft_direction dir) {
     /* Validate input is power of 2 */
     CHECK_POWER_OF_TWO(n);
     
+    fft_engine_t engine = fft_engine_for(n, dir);
+    if (engine == FFT_ENGINE_STOCKHAM) {
+        stockham_fft(x, n, dir);
+        return;
+    }
+    if (engine == FFT_ENGINE_SIXSTEP) {
+        fft_sixstep(x, n, dir);
+        return;
+    }
+    if (engine == FFT_ENGINE_CODELET && fft_codelet(x, n, dir)) {
+        return;
+    }
+    
     int log2n = log2_int(n);
     
     /* 
@@ -67,12 +86,16 @@ void radix2_dit_fft(complex_t* x, int n, fft_direction dir) {
      * Reorder array so that element at index i moves to bit_reverse(i)
      * This allows the iterative algorithm to work in-place
      */
-    for (int i = 0; i < n; i++) {
-        int j = bit_reverse(i, log2n);
-        if (i < j) {  /* Swap only once */
-            complex_t temp = x[i];
-            x[i] = x[j];
-            x[j] = temp;
+    if (engine == FFT_ENGINE_RADIX2_COBRA) {
+        bit_reverse_permute_cobra(x, n);
+    } else {
+        for (int i = 0; i < n; i++) {
+            int j = bit_reverse(i, log2n);
+            if (i < j) {  /* Swap only once */
+                complex_t temp = x[i];
+                x[i] = x[j];
+                x[j] = temp;
+            }
         }
     }
     
@@ -119,6 +142,94 @@ void radix2_dit_fft(complex_t* x, int n, fft_direction dir) {
     }
 }
 
+/**
+ * @brief Cache-blocked in-place bit-reversal permutation (COBRA)
+ * 
+ * @details
+ * Index bits are split as i = (a, c, d) with a and d holding
+ * COBRA_LOG_BLOCK bits each, so rev(i) = (rev(d), rev(c), rev(a)).
+ * For every middle part c the 2^b x 2^b block of elements sharing it is
+ * gathered into a small buffer with sequential reads, then scattered
+ * with its rows and columns exchanged into the block of rev(c). Both
+ * blocks stay in L1 cache, unlike the n random-access swaps of the plain
+ * loop. Blocks c and rev(c) are processed together so the permutation
+ * stays in place.
+ * 
+ * References:
+ * [1] Carter, L., & Gatlin, K. S. (1998). "Towards an optimal
+ *     bit-reversal permutation program"
+ * 
+ * @param x Input/output array of complex numbers
+ * @param n Length of array (must be power of 2)
+ */
+#define COBRA_LOG_BLOCK 4
+
+void bit_reverse_permute_cobra(complex_t* x, int n) {
+    int log2n = log2_int(n);
+    int b = COBRA_LOG_BLOCK;
+    
+    /* Too small to block, use the plain swap loop */
+    if (log2n < 2 * b) {
+        for (int i = 0; i < n; i++) {
+            int j = bit_reverse(i, log2n);
+            if (i < j) {
+                complex_t temp = x[i];
+                x[i] = x[j];
+                x[j] = temp;
+            }
+        }
+        return;
+    }
+    
+    int m = log2n - 2 * b;
+    int block = 1 << b;
+    int high_shift = m + b;
+    complex_t t1[1 << (2 * COBRA_LOG_BLOCK)];
+    complex_t t2[1 << (2 * COBRA_LOG_BLOCK)];
+    int rev_b[1 << COBRA_LOG_BLOCK];
+    
+    for (int a = 0; a < block; a++) {
+        rev_b[a] = bit_reverse(a, b);
+    }
+    
+    for (int c = 0; c < (1 << m); c++) {
+        int cr = bit_reverse(c, m);
+        if (cr < c) continue;  /* Handled together with block cr */
+        
+        /* Gather: sequential reads of rows a, columns d */
+        for (int a = 0; a < block; a++) {
+            const complex_t* src = &x[(a << high_shift) | (c << b)];
+            for (int d = 0; d < block; d++) {
+                t1[a * block + d] = src[d];
+            }
+        }
+        if (cr != c) {
+            for (int a = 0; a < block; a++) {
+                const complex_t* src = &x[(a << high_shift) | (cr << b)];
+                for (int d = 0; d < block; d++) {
+                    t2[a * block + d] = src[d];
+                }
+            }
+        }
+        
+        /* Scatter: element (a, c, d) goes to (rev(d), rev(c), rev(a)) */
+        for (int d = 0; d < block; d++) {
+            complex_t* dst = &x[(rev_b[d] << high_shift) | (cr << b)];
+            for (int a = 0; a < block; a++) {
+                dst[rev_b[a]] = t1[a * block + d];
+            }
+        }
+        if (cr != c) {
+            for (int d = 0; d < block; d++) {
+                complex_t* dst = &x[(rev_b[d] << high_shift) | (c << b)];
+                for (int a = 0; a < block; a++) {
+                    dst[rev_b[a]] = t2[a * block + d];
+                }
+            }
+        }
+    }
+}
+
 /**
  * @brief Compute forward FFT using Radix-2 DIT
  * @param x Input/output array
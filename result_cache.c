@@ -0,0 +1,234 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "result_cache.h"
+
+// Payload hash: four 64-bit lanes over 32-byte stripes (the xxHash64
+// round), folded into two independent 64-bit outputs. Not cryptographic;
+// the stored config string is compared on every hit as a second check.
+#define HASH_P1 0x9E3779B185EBCA87ull
+#define HASH_P2 0xC2B2AE3D27D4EB4Full
+#define HASH_P3 0x165667B19E3779F9ull
+#define HASH_P4 0x85EBCA77C2B2AE63ull
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t word) {
+    acc += word * HASH_P2;
+    acc = rotl64(acc, 31);
+    return acc * HASH_P1;
+}
+
+static inline uint64_t avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= HASH_P2;
+    h ^= h >> 29;
+    h *= HASH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t load64(const unsigned char* p) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    return w;
+}
+
+static void hash128(const void* data, size_t len, uint64_t seed, uint64_t out[2]) {
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + len;
+    uint64_t v[4] = {seed + HASH_P1 + HASH_P2, seed + HASH_P2, seed, seed - HASH_P1};
+
+    for (; p + 32 <= end; p += 32) {
+        v[0] = hash_round(v[0], load64(p));
+        v[1] = hash_round(v[1], load64(p + 8));
+        v[2] = hash_round(v[2], load64(p + 16));
+        v[3] = hash_round(v[3], load64(p + 24));
+    }
+    uint64_t tail[4] = {0, 0, 0, 0};
+    memcpy(tail, p, end - p);
+    for (int i = 0; i < 4; i++) {
+        v[i] = hash_round(v[i], tail[i] ^ len);
+    }
+
+    out[0] = avalanche(rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18));
+    out[1] = avalanche((v[0] * HASH_P4) ^ rotl64(v[1], 23) ^ (v[2] * HASH_P3) ^ rotl64(v[3], 41));
+}
+
+uint64_t result_cache_hash(const void* data, size_t len, uint64_t seed) {
+    uint64_t out[2];
+    hash128(data, len, seed, out);
+    return out[0];
+}
+
+static uint32_t read_u32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint16_t read_u16(const unsigned char* p) {
+    uint16_t v;
+    memcpy(&v, p, 2);
+    return v;
+}
+
+// Key from the PCM payload, the format fields and the configuration
+// string. The fmt chunk is rebuilt from the fields a sound_t keeps (16-bit
+// mono PCM is implied), so a mapped file and the same recording already in
+// memory give the same key.
+static void make_key(const char* dir, uint32_t sample_rate, uint32_t bytes_per_second,
+                     const void* data, size_t data_size, const char* config, result_cache_key_t* key) {
+    uint64_t payload[2], meta[2];
+    hash128(data, data_size, 0, payload);
+
+    char header[sizeof(key->config) + 16];
+    uint16_t format[2] = {1, 1};        // PCM, mono
+    uint16_t layout[2] = {2, 16};       // block align, bits per sample
+    memcpy(header, format, 4);
+    memcpy(header + 4, &sample_rate, 4);
+    memcpy(header + 8, &bytes_per_second, 4);
+    memcpy(header + 12, layout, 4);
+    snprintf(key->config, sizeof(key->config), "%s", config);
+    size_t config_len = strlen(key->config);
+    memcpy(header + 16, key->config, config_len);
+    hash128(header, 16 + config_len, HASH_P4, meta);
+
+    key->hash[0] = avalanche(payload[0] ^ rotl64(meta[0], 17));
+    key->hash[1] = avalanche(payload[1] ^ rotl64(meta[1], 29));
+    snprintf(key->path, sizeof(key->path), "%s/%016llx%016llx.track", dir,
+             (unsigned long long)key->hash[0], (unsigned long long)key->hash[1]);
+}
+
+// Hash the recording's fmt chunk and PCM payload in place (mmap), plus
+// the configuration string, into the entry key
+bool result_cache_key(const char* dir, const char* wav_path, const char* config,
+                      result_cache_key_t* key, sound_t* info) {
+    int fd = open(wav_path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 12) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    unsigned char* file = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) return false;
+
+    const unsigned char* fmt = NULL;
+    const unsigned char* data = NULL;
+    uint32_t data_size = 0;
+    if (memcmp(file, "RIFF", 4) == 0 && memcmp(file + 8, "WAVE", 4) == 0) {
+        size_t pos = 12;
+        while (pos + 8 <= size && data == NULL) {
+            uint32_t chunk_size = read_u32(file + pos + 4);
+            if (chunk_size > size - pos - 8) break;
+            if (memcmp(file + pos, "fmt ", 4) == 0 && chunk_size >= 16) {
+                fmt = file + pos + 8;
+            } else if (memcmp(file + pos, "data", 4) == 0) {
+                data = file + pos + 8;
+                data_size = chunk_size;
+            }
+            pos += 8 + chunk_size + (chunk_size & 1);
+        }
+    }
+
+    // Same restrictions as LoadWav: 16-bit mono PCM
+    bool ok = fmt != NULL && data != NULL &&
+              read_u16(fmt) == 1 && read_u16(fmt + 2) == 1 && read_u16(fmt + 14) == 16;
+    if (ok) {
+        // Whole samples only, as LoadWav reads them
+        make_key(dir, read_u32(fmt + 4), read_u32(fmt + 8), data, data_size & ~1u, config, key);
+        info->samples = data_size / 2;
+        info->sample_rate = (int32_t)read_u32(fmt + 4);
+        info->bytes_per_second = (int32_t)read_u32(fmt + 8);
+        info->data = NULL;
+    }
+    munmap(file, size);
+    return ok;
+}
+
+void result_cache_key_sound(const char* dir, const sound_t* sound, const char* config,
+                            result_cache_key_t* key) {
+    make_key(dir, (uint32_t)sound->sample_rate, (uint32_t)sound->bytes_per_second, sound->data,
+             (size_t)sound->samples * sizeof(int16_t), config, key);
+}
+
+static bool read_entry_header(FILE* entry, const result_cache_key_t* key) {
+    char magic[4];
+    uint32_t version, record_size, config_len;
+    char config[sizeof(key->config)];
+    if (fread(magic, 1, 4, entry) != 4 || memcmp(magic, RESULT_CACHE_MAGIC, 4) != 0 ||
+        fread(&version, 4, 1, entry) != 1 || version != RESULT_CACHE_VERSION ||
+        fread(&record_size, 4, 1, entry) != 1 || record_size != sizeof(pitch_record_t) ||
+        fread(&config_len, 4, 1, entry) != 1 || config_len >= sizeof(config) ||
+        fread(config, 1, config_len, entry) != config_len) {
+        return false;
+    }
+    config[config_len] = '\0';
+    return strcmp(config, key->config) == 0;
+}
+
+FILE* result_cache_lookup(const result_cache_key_t* key) {
+    FILE* entry = fopen(key->path, "rb");
+    if (entry == NULL) return NULL;
+    if (!read_entry_header(entry, key)) {
+        PRINT_ERROR("%s: damaged or mismatched cache entry, ignoring it", key->path);
+        fclose(entry);
+        return NULL;
+    }
+    return entry;
+}
+
+void result_cache_replay(FILE* entry, result_sink_t* sink) {
+    pitch_record_t records[1024];
+    size_t count;
+    while ((count = fread(records, sizeof(pitch_record_t), 1024, entry)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            result_sink_write(sink, &records[i]);
+        }
+    }
+    fclose(entry);
+}
+
+static void temp_path(const result_cache_key_t* key, char* path, size_t size) {
+    snprintf(path, size, "%s.%ld.tmp", key->path, (long)getpid());
+}
+
+FILE* result_cache_begin(const result_cache_key_t* key) {
+    char path[sizeof(key->path) + 32];
+    temp_path(key, path, sizeof(path));
+    FILE* entry = fopen(path, "wb");
+    if (entry == NULL) {
+        PRINT_ERROR("%s: Failed to create cache entry", path);
+        return NULL;
+    }
+    uint32_t version = RESULT_CACHE_VERSION;
+    uint32_t record_size = sizeof(pitch_record_t);
+    uint32_t config_len = strlen(key->config);
+    fwrite(RESULT_CACHE_MAGIC, 1, 4, entry);
+    fwrite(&version, 4, 1, entry);
+    fwrite(&record_size, 4, 1, entry);
+    fwrite(&config_len, 4, 1, entry);
+    fwrite(key->config, 1, config_len, entry);
+    return entry;
+}
+
+// Publish the entry with a rename, so readers never see a partial track
+bool result_cache_commit(const result_cache_key_t* key, FILE* entry) {
+    char path[sizeof(key->path) + 32];
+    temp_path(key, path, sizeof(path));
+    bool ok = !ferror(entry);
+    if (fclose(entry) != 0) ok = false;
+    if (ok && rename(path, key->path) != 0) ok = false;
+    if (!ok) {
+        PRINT_ERROR("%s: Failed to write cache entry", key->path);
+        remove(path);
+    }
+    return ok;
+}
@@ -0,0 +1,54 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "result_sink.h"
+#include "wavformat.h"
+
+// Content-addressed cache of pitch tracks. An entry is keyed by a 128-bit
+// hash of the WAV format and PCM payload together with the analysis
+// configuration string, so a renamed or copied recording still hits and
+// any change to the samples or the settings misses. Entries hold the raw
+// pitch records and are replayed through a result sink, so every output
+// format is served from the same entry.
+//
+// Layout of <dir>/<key>.track (host byte order): "PTRK", uint32 version,
+// uint32 record size, uint32 config length, the config string, then the
+// pitch_record_t array.
+
+#define RESULT_CACHE_MAGIC "PTRK"
+#define RESULT_CACHE_VERSION 1
+
+typedef struct {
+    uint64_t hash[2];
+    char config[256];
+    char path[4096];       // entry file for this key
+} result_cache_key_t;
+
+// Hash the recording without decoding it. Fills samples, sample_rate and
+// bytes_per_second of `info` (data stays NULL); false if the file is not
+// a 16-bit mono PCM WAV, in which case the caller should use LoadWav.
+bool result_cache_key(const char* dir, const char* wav_path, const char* config,
+                      result_cache_key_t* key, sound_t* info);
+// The same key for a recording already in memory (LoadWav, prefetcher),
+// without reading the file again
+void result_cache_key_sound(const char* dir, const sound_t* sound, const char* config,
+                            result_cache_key_t* key);
+
+// 64-bit hash of a block, chained through `seed`; for folding tables the
+// analysis depends on into the configuration string
+uint64_t result_cache_hash(const void* data, size_t len, uint64_t seed);
+
+// Open the entry for a key, NULL on a miss (or a damaged entry)
+FILE* result_cache_lookup(const result_cache_key_t* key);
+// Replay an entry from result_cache_lookup into the sink and close it
+void result_cache_replay(FILE* entry, result_sink_t* sink);
+
+// Start a new entry: records written to the returned file (see
+// result_sink_capture) become visible only after result_cache_commit
+FILE* result_cache_begin(const result_cache_key_t* key);
+bool result_cache_commit(const result_cache_key_t* key, FILE* entry);
+
+#endif
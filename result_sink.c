@@ -0,0 +1,276 @@
+#include <pthread.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "result_sink.h"
+#include "pitch_detection.h"
+
+// Records are collected in batches; a full batch is formatted either by a
+// writer thread (while the analysis fills the other batch) or in one go on
+// the calling thread, and written with a single large fwrite.
+#define RESULT_SINK_BATCH 4096
+#define RESULT_SINK_TEXT_FLUSH (1 << 20)
+
+static const char* format_names[RESULT_FORMAT_COUNT] = {"text", "jsonl", "csv", "binary"};
+
+struct result_sink {
+    FILE* out;
+    result_format_t format;
+    const char* const* method_names;
+
+    pitch_record_t* batches[2];
+    pitch_record_t* filling;        // batch the analysis writes into
+    int filling_count;
+
+    char* text;                     // formatted output waiting for fwrite
+    size_t text_len;
+    size_t text_cap;
+
+    int threaded;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pitch_record_t* pending;        // batch owned by the writer, NULL when idle
+    int pending_count;
+    int stop;
+
+    FILE* capture;                  // raw copy of every record, NULL if off
+};
+
+int result_format_from_name(const char* name) {
+    for (int i = 0; i < RESULT_FORMAT_COUNT; i++) {
+        if (strcmp(name, format_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+result_format_t result_sink_format(const result_sink_t* sink) {
+    return sink->format;
+}
+
+static void text_reserve(result_sink_t* sink, size_t extra) {
+    if (sink->text_len + extra <= sink->text_cap) return;
+    size_t cap = sink->text_cap ? sink->text_cap : 4096;
+    while (cap < sink->text_len + extra) cap *= 2;
+    char* text = realloc(sink->text, cap);
+    if (text == NULL) {
+        fprintf(stderr, "Error: Failed to allocate result buffer\n");
+        exit(EXIT_FAILURE);
+    }
+    sink->text = text;
+    sink->text_cap = cap;
+}
+
+static void text_write_out(result_sink_t* sink) {
+    if (sink->text_len > 0) {
+        fwrite(sink->text, 1, sink->text_len, sink->out);
+        sink->text_len = 0;
+    }
+}
+
+static const char* method_name(const result_sink_t* sink, int method) {
+    return (sink->method_names && method >= 0) ? sink->method_names[method] : "unknown";
+}
+
+static void format_record(result_sink_t* sink, const pitch_record_t* r) {
+    const char* method = method_name(sink, r->method);
+    const char* note = (r->note >= 0) ? note_name(r->note) : NULL;
+    int has_confidence = !isnan(r->confidence);
+    size_t room = 256;
+    text_reserve(sink, room);
+    char* p = sink->text + sink->text_len;
+    int len = 0;
+
+    switch (sink->format) {
+    case RESULT_FORMAT_TEXT:
+        len = snprintf(p, room, "Frame:%u\nMethod: %s\nDetected pitch: %.2f Hz\n",
+                       r->frame, method, r->frequency);
+        if (note && fabs(r->cents) < 1) {
+            len += snprintf(p + len, room - len, "Musical note: %s (in tune)\n", note);
+        } else if (note) {
+            len += snprintf(p + len, room - len, "Musical note: %s (%+.0f cents)\n", note, r->cents);
+        }
+        if (has_confidence) {
+            len += snprintf(p + len, room - len, "Confidence: %.1f%%\n\n", r->confidence * 100);
+        }
+        break;
+    case RESULT_FORMAT_JSONL:
+        len = snprintf(p, room, "{\"frame\":%u,\"time\":%.6f,\"method\":\"%s\",\"frequency\":%.4f,",
+                       r->frame, r->timestamp, method, r->frequency);
+        if (note) {
+            len += snprintf(p + len, room - len, "\"note\":\"%s\",\"cents\":%.2f,", note, r->cents);
+        } else {
+            len += snprintf(p + len, room - len, "\"note\":null,\"cents\":null,");
+        }
+        if (has_confidence) {
+            len += snprintf(p + len, room - len, "\"confidence\":%.4f}\n", r->confidence);
+        } else {
+            len += snprintf(p + len, room - len, "\"confidence\":null}\n");
+        }
+        break;
+    case RESULT_FORMAT_CSV:
+        len = snprintf(p, room, "%u,%.6f,%s,%.4f,%s,", r->frame, r->timestamp, method,
+                       r->frequency, note ? note : "");
+        if (note) len += snprintf(p + len, room - len, "%.2f", r->cents);
+        len += snprintf(p + len, room - len, ",");
+        if (has_confidence) len += snprintf(p + len, room - len, "%.4f", r->confidence);
+        len += snprintf(p + len, room - len, "\n");
+        break;
+    case RESULT_FORMAT_BINARY: {
+        uint32_t frame = r->frame;
+        uint16_t method_id = (uint16_t)r->method;
+        int16_t note_id = (int16_t)r->note;
+        float values[4] = {(float)r->timestamp, (float)r->frequency,
+                           (float)r->cents, (float)r->confidence};
+        memcpy(p, &frame, 4);
+        memcpy(p + 4, &method_id, 2);
+        memcpy(p + 6, &note_id, 2);
+        memcpy(p + 8, values, sizeof(values));
+        len = RESULT_BINARY_RECORD_SIZE;
+        break;
+    }
+    default:
+        break;
+    }
+
+    sink->text_len += len;
+}
+
+static void format_batch(result_sink_t* sink, const pitch_record_t* records, int count) {
+    for (int i = 0; i < count; i++) {
+        format_record(sink, &records[i]);
+        if (sink->text_len >= RESULT_SINK_TEXT_FLUSH) {
+            text_write_out(sink);
+        }
+    }
+    text_write_out(sink);
+}
+
+static void* writer_thread(void* arg) {
+    result_sink_t* sink = (result_sink_t*)arg;
+
+    pthread_mutex_lock(&sink->lock);
+    for (;;) {
+        while (sink->pending == NULL && !sink->stop) {
+            pthread_cond_wait(&sink->cond, &sink->lock);
+        }
+        if (sink->pending == NULL && sink->stop) break;
+
+        pitch_record_t* batch = sink->pending;
+        int count = sink->pending_count;
+        pthread_mutex_unlock(&sink->lock);
+
+        format_batch(sink, batch, count);
+
+        pthread_mutex_lock(&sink->lock);
+        sink->pending = NULL;
+        pthread_cond_broadcast(&sink->cond);
+    }
+    pthread_mutex_unlock(&sink->lock);
+    return NULL;
+}
+
+// Hand the filling batch to the formatter and wait for the previous one
+static void submit_batch(result_sink_t* sink, int wait_idle) {
+    if (sink->capture != NULL && sink->filling_count > 0) {
+        fwrite(sink->filling, sizeof(pitch_record_t), sink->filling_count, sink->capture);
+    }
+    if (!sink->threaded) {
+        format_batch(sink, sink->filling, sink->filling_count);
+        sink->filling_count = 0;
+        return;
+    }
+
+    pthread_mutex_lock(&sink->lock);
+    while (sink->pending != NULL) {
+        pthread_cond_wait(&sink->cond, &sink->lock);
+    }
+    if (sink->filling_count > 0) {
+        sink->pending = sink->filling;
+        sink->pending_count = sink->filling_count;
+        sink->filling = (sink->filling == sink->batches[0]) ? sink->batches[1] : sink->batches[0];
+        sink->filling_count = 0;
+        pthread_cond_broadcast(&sink->cond);
+    }
+    while (wait_idle && sink->pending != NULL) {
+        pthread_cond_wait(&sink->cond, &sink->lock);
+    }
+    pthread_mutex_unlock(&sink->lock);
+}
+
+result_sink_t* result_sink_open(FILE* out, result_format_t format,
+                                const char* const* method_names, int threaded) {
+    result_sink_t* sink = calloc(1, sizeof(result_sink_t));
+    if (sink == NULL) return NULL;
+
+    sink->out = out;
+    sink->format = format;
+    sink->method_names = method_names;
+    sink->batches[0] = malloc(RESULT_SINK_BATCH * sizeof(pitch_record_t));
+    sink->batches[1] = malloc(RESULT_SINK_BATCH * sizeof(pitch_record_t));
+    if (sink->batches[0] == NULL || sink->batches[1] == NULL) {
+        free(sink->batches[0]);
+        free(sink->batches[1]);
+        free(sink);
+        return NULL;
+    }
+    sink->filling = sink->batches[0];
+
+    if (format == RESULT_FORMAT_CSV) {
+        fputs("frame,time,method,frequency,note,cents,confidence\n", out);
+    } else if (format == RESULT_FORMAT_BINARY) {
+        uint16_t version = RESULT_BINARY_VERSION;
+        uint16_t record_size = RESULT_BINARY_RECORD_SIZE;
+        fwrite(RESULT_BINARY_MAGIC, 1, 4, out);
+        fwrite(&version, 2, 1, out);
+        fwrite(&record_size, 2, 1, out);
+    }
+
+    if (threaded) {
+        pthread_mutex_init(&sink->lock, NULL);
+        pthread_cond_init(&sink->cond, NULL);
+        sink->threaded = (pthread_create(&sink->thread, NULL, writer_thread, sink) == 0);
+        if (!sink->threaded) {
+            pthread_cond_destroy(&sink->cond);
+            pthread_mutex_destroy(&sink->lock);
+        }
+    }
+    return sink;
+}
+
+// Also append every record, unformatted, to `capture` (result cache entries)
+void result_sink_capture(result_sink_t* sink, FILE* capture) {
+    sink->capture = capture;
+}
+
+void result_sink_write(result_sink_t* sink, const pitch_record_t* record) {
+    sink->filling[sink->filling_count++] = *record;
+    if (sink->filling_count == RESULT_SINK_BATCH) {
+        submit_batch(sink, 0);
+    }
+}
+
+void result_sink_flush(result_sink_t* sink) {
+    submit_batch(sink, 1);
+    fflush(sink->out);
+}
+
+void result_sink_close(result_sink_t* sink) {
+    if (sink == NULL) return;
+    result_sink_flush(sink);
+
+    if (sink->threaded) {
+        pthread_mutex_lock(&sink->lock);
+        sink->stop = 1;
+        pthread_cond_broadcast(&sink->cond);
+        pthread_mutex_unlock(&sink->lock);
+        pthread_join(sink->thread, NULL);
+        pthread_cond_destroy(&sink->cond);
+        pthread_mutex_destroy(&sink->lock);
+    }
+
+    free(sink->batches[0]);
+    free(sink->batches[1]);
+    free(sink->text);
+    free(sink);
+}
@@ -0,0 +1,44 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// One analyzed frame
+typedef struct {
+    uint32_t frame;        // frame index (1-based, as printed by the analyzer)
+    double timestamp;      // start of the frame in seconds
+    int method;            // index into the sink's method names
+    double frequency;      // Hz, 0 if no pitch
+    int note;              // index into the note table, -1 if no pitch
+    double cents;          // offset from the note
+    double confidence;     // 0..1, NAN if the method has no confidence
+} pitch_record_t;
+
+typedef enum {
+    RESULT_FORMAT_TEXT = 0,   // human-readable, one block per frame
+    RESULT_FORMAT_JSONL,      // one JSON object per line
+    RESULT_FORMAT_CSV,        // header line, then one row per frame
+    RESULT_FORMAT_BINARY,     // 8-byte header, then fixed 24-byte records
+    RESULT_FORMAT_COUNT
+} result_format_t;
+
+// Binary layout (host byte order): "PREC", uint16 version, uint16 record
+// size, then per record uint32 frame, uint16 method, int16 note and float
+// timestamp, frequency, cents, confidence
+#define RESULT_BINARY_MAGIC "PREC"
+#define RESULT_BINARY_VERSION 1
+#define RESULT_BINARY_RECORD_SIZE 24
+
+typedef struct result_sink result_sink_t;
+
+result_sink_t* result_sink_open(FILE* out, result_format_t format,
+                                const char* const* method_names, int threaded);
+void result_sink_write(result_sink_t* sink, const pitch_record_t* record);
+void result_sink_flush(result_sink_t* sink);
+void result_sink_capture(result_sink_t* sink, FILE* capture);
+void result_sink_close(result_sink_t* sink);
+result_format_t result_sink_format(const result_sink_t* sink);
+int result_format_from_name(const char* name);
+
+#endif
@@ -0,0 +1,174 @@
+#include "spectral_peaks.h"
+#include "frame_kernels.h"
+
+struct peak_engine {
+    int n;
+    double sample_rate;
+    peak_config_t config;
+    int lo, hi;             // candidate bins [lo, hi)
+    double* magnitude;      // n/2 + 1 bins, for complex input
+    double* prefix;         // running sum of magnitude, n/2 + 2 entries
+    int* bins;              // local maxima of the current frame
+    int* heap;              // min-heap on magnitude, max_peaks entries
+};
+
+peak_config_t peak_default_config(void) {
+    peak_config_t config;
+    config.max_peaks = 16;
+    config.min_magnitude = 0.1;
+    config.floor_ratio = 3.0;
+    config.floor_width = 16;
+    config.min_freq = 0;
+    config.max_freq = 0;
+    return config;
+}
+
+peak_engine_t* peak_engine_create(int n, double sample_rate, const peak_config_t* config) {
+    peak_engine_t* e = (peak_engine_t*)fft_calloc(1, sizeof(peak_engine_t));
+    CHECK_NULL(e, "Failed to allocate peak engine");
+    e->n = n;
+    e->sample_rate = sample_rate;
+    e->config = *config;
+    if (e->config.max_peaks < 1) e->config.max_peaks = 1;
+    if (e->config.floor_width < 1) e->config.floor_width = 1;
+
+    e->lo = (int)ceil(config->min_freq * n / sample_rate);
+    if (e->lo < 1) e->lo = 1;
+    e->hi = n / 2 - 1;
+    if (config->max_freq > 0 && (int)(config->max_freq * n / sample_rate) + 1 < e->hi) {
+        e->hi = (int)(config->max_freq * n / sample_rate) + 1;
+    }
+
+    e->magnitude = (double*)fft_malloc((n / 2 + 1) * sizeof(double));
+    e->prefix = (double*)fft_malloc((n / 2 + 2) * sizeof(double));
+    e->bins = (int*)fft_malloc((n / 2 + 1) * sizeof(int));
+    e->heap = (int*)fft_malloc(e->config.max_peaks * sizeof(int));
+    CHECK_NULL(e->magnitude, "Failed to allocate peak magnitudes");
+    CHECK_NULL(e->prefix, "Failed to allocate peak noise floor");
+    CHECK_NULL(e->bins, "Failed to allocate peak bins");
+    CHECK_NULL(e->heap, "Failed to allocate peak heap");
+    return e;
+}
+
+void peak_engine_free(peak_engine_t* e) {
+    if (e == NULL) return;
+    fft_free(e->heap);
+    fft_free(e->bins);
+    fft_free(e->prefix);
+    fft_free(e->magnitude);
+    fft_free(e);
+}
+
+static void heap_sift_down(const double* mag, int* heap, int count, int i) {
+    for (;;) {
+        int smallest = i;
+        int l = 2 * i + 1;
+        int r = l + 1;
+        if (l < count && mag[heap[l]] < mag[heap[smallest]]) smallest = l;
+        if (r < count && mag[heap[r]] < mag[heap[smallest]]) smallest = r;
+        if (smallest == i) return;
+        int tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+static void heap_push(const double* mag, int* heap, int count, int bin) {
+    int c = count;
+    heap[c] = bin;
+    while (c > 0 && mag[heap[(c - 1) / 2]] > mag[heap[c]]) {
+        int parent = (c - 1) / 2;
+        int tmp = heap[parent];
+        heap[parent] = heap[c];
+        heap[c] = tmp;
+        c = parent;
+    }
+}
+
+// Quinn's second estimator
+static double quinn_tau(double x) {
+    double r = sqrt(2.0 / 3.0);
+    return 0.25 * log(3 * x * x + 6 * x + 1) - sqrt(6.0) / 24 * log((x + 1 - r) / (x + 1 + r));
+}
+
+static double quinn_offset(const complex_t* spectrum, int k) {
+    complex_t center = spectrum[k];
+    if (cabs(center) == 0) return 0;
+    double ap = creal(spectrum[k + 1] / center);
+    double am = creal(spectrum[k - 1] / center);
+    double dp = -ap / (1 - ap);
+    double dm = am / (1 - am);
+    return (dp + dm) / 2 + quinn_tau(dp * dp) - quinn_tau(dm * dm);
+}
+
+// Jain's method: ratio of the peak to its larger neighbour
+static double jain_offset(const double* mag, int k) {
+    double y1 = mag[k - 1];
+    double y2 = mag[k];
+    double y3 = mag[k + 1];
+    if (y1 > y3) {
+        double a = y2 / y1;
+        return a / (1 + a) - 1;
+    }
+    if (y2 == 0) return 0;
+    double a = y3 / y2;
+    return a / (1 + a);
+}
+
+static int run(peak_engine_t* e, const double* mag, const complex_t* spectrum, peak_t* peaks) {
+    int half = e->n / 2;
+    int width = e->config.floor_width;
+    if (e->hi <= e->lo) return 0;
+
+    e->prefix[0] = 0;
+    for (int i = 0; i <= half; i++) {
+        e->prefix[i + 1] = e->prefix[i] + mag[i];
+    }
+
+    // Vectorized local-maximum scan, then the noise floor test per candidate
+    int candidates = frame_local_maxima(mag, e->lo, e->hi, e->config.min_magnitude, e->bins, half + 1);
+    int count = 0;
+    for (int c = 0; c < candidates; c++) {
+        int k = e->bins[c];
+        int a = (k - width > 0) ? k - width : 0;
+        int b = (k + width < half) ? k + width : half;
+        double floor = (e->prefix[b + 1] - e->prefix[a]) / (b - a + 1);
+        if (mag[k] <= e->config.floor_ratio * floor) continue;
+        if (count < e->config.max_peaks) {
+            heap_push(mag, e->heap, count++, k);
+        }
+        else if (mag[k] > mag[e->heap[0]]) {
+            e->heap[0] = k;
+            heap_sift_down(mag, e->heap, count, 0);
+        }
+    }
+
+    // Pop weakest first into the back of the list: strongest ends up first
+    for (int i = count - 1; i >= 0; i--) {
+        int k = e->heap[0];
+        e->heap[0] = e->heap[i];
+        heap_sift_down(mag, e->heap, i, 0);
+
+        double d = spectrum ? quinn_offset(spectrum, k) : jain_offset(mag, k);
+        if (!isfinite(d) || fabs(d) > 1) d = 0;
+        // Magnitude at the refined frequency: undo the sinc roll-off
+        double roll = fabs(d) > 0.5 ? 0.5 : fabs(d);
+        double gain = roll > 1e-9 ? PI * roll / sin(PI * roll) : 1.0;
+        peaks[i].bin = k;
+        peaks[i].frequency = (k + d) * e->sample_rate / e->n;
+        peaks[i].magnitude = mag[k] * gain;
+    }
+    return count;
+}
+
+int peak_engine_run(peak_engine_t* e, const complex_t* spectrum, peak_t* peaks) {
+    STATS_BEGIN(span);
+    frame_magnitude(spectrum, e->n / 2 + 1, e->magnitude);
+    STATS_END(STATS_MAGNITUDE, span);
+    return run(e, e->magnitude, spectrum, peaks);
+}
+
+int peak_engine_run_magnitude(peak_engine_t* e, const double* magnitude, peak_t* peaks) {
+    return run(e, magnitude, NULL, peaks);
+}
@@ -0,0 +1,39 @@
+#ifndef SPECTRAL_PEAKS_H
+#define SPECTRAL_PEAKS_H
+
+#include "fft_common.h"
+#include "audio_spectrum.h"
+
+// Sparse spectral peak extraction. A bin is a peak when it is a local
+// maximum, above min_magnitude, and floor_ratio times above the local noise
+// floor (mean magnitude over floor_width bins on either side). The
+// max_peaks strongest survive, selected with a min-heap while scanning, and
+// come back strongest first with the frequency and magnitude refined
+// between bins: Quinn's second estimator when the complex spectrum is
+// available, Jain's method on magnitudes alone. Both estimators assume the
+// rectangular-window kernel; on windowed frames the refinement is partial
+// but stays within the peak bin's neighbourhood.
+
+typedef struct {
+    int max_peaks;          // K: strongest peaks kept
+    double min_magnitude;   // absolute threshold
+    double floor_ratio;     // peak / local mean magnitude
+    int floor_width;        // bins on each side of the local mean
+    double min_freq;        // search range in Hz (max_freq 0: up to Nyquist)
+    double max_freq;
+} peak_config_t;
+
+typedef struct peak_engine peak_engine_t;
+
+peak_config_t peak_default_config(void);
+
+// Buffers for n-point spectra; reusable across frames of the same size
+peak_engine_t* peak_engine_create(int n, double sample_rate, const peak_config_t* config);
+void peak_engine_free(peak_engine_t* engine);
+
+// Peaks of a forward spectrum (n bins) or of its magnitude (n/2 + 1 bins)
+// into peaks[0..max_peaks), strongest first; returns the count
+int peak_engine_run(peak_engine_t* engine, const complex_t* spectrum, peak_t* peaks);
+int peak_engine_run_magnitude(peak_engine_t* engine, const double* magnitude, peak_t* peaks);
+
+#endif
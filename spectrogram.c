@@ -0,0 +1,188 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "spectrogram.h"
+#include "wavformat.h"
+
+// Export the STFT magnitudes of a recording (window + radix2_dit_fft)
+bool spectrogram_export(const char* path, const int16_t* samples, uint32_t count,
+                        int n, int hop, double sample_rate, window_type_t window) {
+    if (!is_power_of_two(n) || hop <= 0) {
+        PRINT_ERROR("%s: invalid frame size %d / hop %d", path, n, hop);
+        return false;
+    }
+
+    spectrogram_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SPECTROGRAM_MAGIC, 4);
+    header.version = SPECTROGRAM_VERSION;
+    header.n = n;
+    header.hop = hop;
+    header.sample_rate = sample_rate;
+    header.window = window;
+    header.bins = n / 2 + 1;
+    header.num_frames = (count + (uint64_t)hop - 1) / hop;
+    header.index_offset = sizeof(spectrogram_header_t);
+
+    uint64_t index_end = header.index_offset + header.num_frames * sizeof(spectrogram_index_entry_t);
+    header.data_offset = (index_end + SPECTROGRAM_ALIGN - 1) / SPECTROGRAM_ALIGN * SPECTROGRAM_ALIGN;
+    size_t frame_bytes = header.bins * sizeof(float);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        PRINT_ERROR("%s: Failed to open file", path);
+        return false;
+    }
+
+    spectrogram_index_entry_t* index = fft_calloc(header.num_frames ? header.num_frames : 1,
+                                              sizeof(spectrogram_index_entry_t));
+    complex_t* signal = allocate_complex_array(n);
+    float* row = fft_malloc(frame_bytes);
+    bool ok = (index != NULL && signal != NULL && row != NULL);
+
+    // Frames are written first; the index (with energies) follows once known
+    if (ok && fseeko(file, (off_t)header.data_offset, SEEK_SET) != 0) ok = false;
+
+    for (uint64_t f = 0; ok && f < header.num_frames; f++) {
+        uint64_t start = f * hop;
+        for (int i = 0; i < n; i++) {
+            uint64_t pos = start + i;
+            signal[i] = (pos < count) ? (double)samples[pos] : 0.0;
+        }
+        apply_window(signal, n, window);
+        radix2_dit_fft(signal, n, FFT_FORWARD);
+
+        double energy = 0;
+        for (uint32_t k = 0; k < header.bins; k++) {
+            double mag = cabs(signal[k]);
+            row[k] = (float)mag;
+            energy += mag * mag;
+        }
+
+        index[f].sample = start;
+        index[f].offset = header.data_offset + f * frame_bytes;
+        index[f].energy = (float)energy;
+
+        if (fwrite(row, 1, frame_bytes, file) != frame_bytes) ok = false;
+    }
+
+    if (ok) {
+        ok = fseeko(file, 0, SEEK_SET) == 0 &&
+             fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(index, sizeof(spectrogram_index_entry_t), header.num_frames, file) == header.num_frames;
+    }
+    if (!ok) {
+        PRINT_ERROR("%s: Failed to write spectrogram", path);
+    }
+
+    fft_free(row);
+    free_complex_array(signal);
+    fft_free(index);
+    if (fclose(file) != 0) ok = false;
+    return ok;
+}
+
+// Map a spectrogram file read-only and validate its header and index
+bool spectrogram_open(const char* path, spectrogram_t* sg) {
+    memset(sg, 0, sizeof(*sg));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        PRINT_ERROR("%s: Failed to open file", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(spectrogram_header_t)) {
+        PRINT_ERROR("%s: File too small for a spectrogram header", path);
+        close(fd);
+        return false;
+    }
+
+    void* base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        PRINT_ERROR("%s: Failed to map file", path);
+        return false;
+    }
+
+    const spectrogram_header_t* header = (const spectrogram_header_t*)base;
+    size_t size = st.st_size;
+    uint64_t data_end = header->data_offset + header->num_frames * header->bins * sizeof(float);
+    uint64_t index_end = header->index_offset + header->num_frames * sizeof(spectrogram_index_entry_t);
+
+    if (memcmp(header->magic, SPECTROGRAM_MAGIC, 4) != 0 ||
+        header->version != SPECTROGRAM_VERSION ||
+        header->bins != header->n / 2 + 1 ||
+        index_end > size || data_end > size) {
+        PRINT_ERROR("%s: Not a valid spectrogram file", path);
+        munmap(base, size);
+        return false;
+    }
+
+    sg->base = (const uint8_t*)base;
+    sg->size = size;
+    sg->header = header;
+    sg->index = (const spectrogram_index_entry_t*)(sg->base + header->index_offset);
+
+    size_t frame_bytes = header->bins * sizeof(float);
+    for (uint64_t f = 0; f < header->num_frames; f++) {
+        if (sg->index[f].offset < header->data_offset ||
+            sg->index[f].offset + frame_bytes > size) {
+            PRINT_ERROR("%s: Frame %llu points outside the file", path, (unsigned long long)f);
+            spectrogram_close(sg);
+            return false;
+        }
+    }
+
+    // Queries usually walk forward through a time range
+    madvise(base, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void spectrogram_close(spectrogram_t* sg) {
+    if (sg->base) {
+        munmap((void*)sg->base, sg->size);
+    }
+    memset(sg, 0, sizeof(*sg));
+}
+
+// Magnitudes of one frame, straight from the mapping
+const float* spectrogram_frame(const spectrogram_t* sg, uint64_t frame) {
+    if (frame >= sg->header->num_frames) return NULL;
+    return (const float*)(sg->base + sg->index[frame].offset);
+}
+
+double spectrogram_frame_time(const spectrogram_t* sg, uint64_t frame) {
+    return sg->index[frame].sample / sg->header->sample_rate;
+}
+
+// Index of the last frame starting at or before the given time
+uint64_t spectrogram_frame_at(const spectrogram_t* sg, double seconds) {
+    if (seconds <= 0 || sg->header->num_frames == 0) return 0;
+
+    uint64_t sample = (uint64_t)(seconds * sg->header->sample_rate);
+    uint64_t lo = 0;
+    uint64_t hi = sg->header->num_frames - 1;
+
+    // The index is sorted by sample, binary search keeps this valid even
+    // if frames are not evenly spaced
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (sg->index[mid].sample <= sample) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// Frame magnitudes widened to double for find_peaks / detect_pitch_peak_magnitude
+void spectrogram_frame_magnitude(const spectrogram_t* sg, uint64_t frame, double* magnitude) {
+    const float* row = spectrogram_frame(sg, frame);
+    for (uint32_t k = 0; k < sg->header->bins; k++) {
+        magnitude[k] = row ? row[k] : 0.0;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SPECTROGRAM_H
+#define SPECTROGRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "audio_spectrum.h"
+
+// On-disk STFT magnitude store. Layout:
+//   spectrogram_header_t
+//   spectrogram_index_entry_t[num_frames]
+//   padding up to data_offset (page aligned)
+//   float magnitudes[num_frames][bins], bins = n/2 + 1
+// The file is memory-mapped for reading, so any time range can be
+// inspected without recomputing FFTs.
+#define SPECTROGRAM_MAGIC "SPGM"
+#define SPECTROGRAM_VERSION 1
+#define SPECTROGRAM_ALIGN 4096
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t n;              // FFT size
+    uint32_t hop;            // samples between frame starts
+    double sample_rate;
+    uint32_t window;         // window_type_t
+    uint32_t bins;           // magnitudes per frame
+    uint64_t num_frames;
+    uint64_t index_offset;   // byte offset of the frame index
+    uint64_t data_offset;    // byte offset of the first frame
+} spectrogram_header_t;
+
+typedef struct {
+    uint64_t sample;         // first sample of the frame
+    uint64_t offset;         // byte offset of the frame's magnitudes
+    float energy;            // sum of squared magnitudes
+    uint32_t reserved;
+} spectrogram_index_entry_t;
+
+typedef struct {
+    const spectrogram_header_t* header;
+    const spectrogram_index_entry_t* index;
+    const uint8_t* base;
+    size_t size;
+} spectrogram_t;
+
+bool spectrogram_export(const char* path, const int16_t* samples, uint32_t count,
+                        int n, int hop, double sample_rate, window_type_t window);
+bool spectrogram_open(const char* path, spectrogram_t* sg);
+void spectrogram_close(spectrogram_t* sg);
+const float* spectrogram_frame(const spectrogram_t* sg, uint64_t frame);
+double spectrogram_frame_time(const spectrogram_t* sg, uint64_t frame);
+uint64_t spectrogram_frame_at(const spectrogram_t* sg, double seconds);
+void spectrogram_frame_magnitude(const spectrogram_t* sg, uint64_t frame, double* magnitude);
+
+#endif
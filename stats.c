@@ -0,0 +1,308 @@
+#include "stats.h"
+
+#ifdef PITCH_STATS
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Latency histogram: 16 linear sub-buckets per power of two of
+// nanoseconds, about 6% resolution from 1 ns up to minutes
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_OCTAVES 40
+#define HIST_BUCKETS (HIST_OCTAVES * HIST_SUB)
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t allocs;
+    uint64_t bytes;
+    uint64_t max_allocs;     // most allocations in a single record
+    uint64_t buckets[HIST_BUCKETS];
+} stats_histogram_t;
+
+// Allocator counters, updated from any thread
+typedef struct {
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t bytes;          // cumulative
+    uint64_t live_bytes;
+    uint64_t peak_bytes;
+    uint64_t file_peak_bytes;   // peak live since stats_file_begin
+} stats_memory_t;
+
+// Counters when the current file started
+typedef struct {
+    uint64_t start_ns;
+    double audio_seconds;
+    uint64_t allocs;
+    uint64_t bytes;
+    stats_histogram_t stages[STATS_STAGE_COUNT];
+    uint64_t frames;
+} stats_file_t;
+
+static const char* stage_names[STATS_STAGE_COUNT] = {
+    "load", "filter", "convert", "window", "transform", "magnitude", "detect", "output"
+};
+
+bool stats_active = false;
+uint64_t stats_nested_ns = 0;
+uint64_t stats_nested_allocs = 0;
+uint64_t stats_nested_bytes = 0;
+
+static stats_histogram_t stages[STATS_STAGE_COUNT];
+static stats_histogram_t frames;
+static uint64_t run_start_ns;
+static stats_memory_t memory;
+static stats_file_t file;
+
+static size_t block_size(void* ptr, size_t requested) {
+#ifdef __GLIBC__
+    (void)requested;
+    return malloc_usable_size(ptr);
+#else
+    return requested;
+#endif
+}
+
+static void raise_peak(uint64_t* peak_bytes, uint64_t live) {
+    uint64_t peak = __atomic_load_n(peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak &&
+           !__atomic_compare_exchange_n(peak_bytes, &peak, live, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void count_allocation(void* ptr, size_t requested) {
+    if (ptr == NULL) return;
+    uint64_t size = block_size(ptr, requested);
+    __atomic_add_fetch(&memory.allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&memory.bytes, size, __ATOMIC_RELAXED);
+    uint64_t live = __atomic_add_fetch(&memory.live_bytes, size, __ATOMIC_RELAXED);
+    raise_peak(&memory.peak_bytes, live);
+    raise_peak(&memory.file_peak_bytes, live);
+}
+
+void* stats_malloc(size_t size) {
+    void* ptr = malloc(size);
+    count_allocation(ptr, size);
+    return ptr;
+}
+
+void* stats_calloc(size_t count, size_t size) {
+    void* ptr = calloc(count, size);
+    count_allocation(ptr, count * size);
+    return ptr;
+}
+
+void stats_free(void* ptr) {
+    if (ptr == NULL) return;
+    // Without malloc_usable_size the byte counts only cover allocations
+    uint64_t size = block_size(ptr, 0);
+    __atomic_add_fetch(&memory.frees, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&memory.live_bytes, size, __ATOMIC_RELAXED);
+    free(ptr);
+}
+
+void stats_span_allocations(stats_span_t* span) {
+    span->allocs = __atomic_load_n(&memory.allocs, __ATOMIC_RELAXED);
+    span->bytes = __atomic_load_n(&memory.bytes, __ATOMIC_RELAXED);
+    span->nested_allocs = stats_nested_allocs;
+    span->nested_bytes = stats_nested_bytes;
+}
+
+uint64_t stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void stats_enable(void) {
+    memset(stages, 0, sizeof(stages));
+    memset(&frames, 0, sizeof(frames));
+    stats_nested_ns = 0;
+    stats_nested_allocs = 0;
+    stats_nested_bytes = 0;
+    run_start_ns = stats_now();
+    stats_active = true;
+}
+
+static int bucket_of(uint64_t ns) {
+    if (ns < HIST_SUB) return (int)ns;
+    int octave = 63 - __builtin_clzll(ns);          // ns >= 2^octave
+    int sub = (int)(ns >> (octave - HIST_SUB_BITS)) & (HIST_SUB - 1);
+    int bucket = (octave - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+    return bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1;
+}
+
+// Lower bound of a bucket in ns
+static double bucket_value(int bucket) {
+    if (bucket < HIST_SUB) return bucket;
+    int octave = bucket / HIST_SUB + HIST_SUB_BITS - 1;
+    int sub = bucket % HIST_SUB;
+    return ldexp(HIST_SUB + sub, octave - HIST_SUB_BITS);
+}
+
+static void histogram_add(stats_histogram_t* h, uint64_t ns, uint64_t allocs, uint64_t bytes) {
+    h->count++;
+    h->total_ns += ns;
+    h->allocs += allocs;
+    h->bytes += bytes;
+    if (allocs > h->max_allocs) h->max_allocs = allocs;
+    h->buckets[bucket_of(ns)]++;
+}
+
+static double histogram_percentile(const stats_histogram_t* h, double p) {
+    if (h->count == 0) return 0;
+    uint64_t rank = (uint64_t)ceil(p * h->count);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) return bucket_value(b);
+    }
+    return bucket_value(HIST_BUCKETS - 1);
+}
+
+// Exclusive share of a counter: total since the span began minus what
+// inner spans already claimed. Afterwards enclosing spans see this one as
+// a single inner span.
+static uint64_t claim(uint64_t total, uint64_t* nested, uint64_t nested_at_start) {
+    uint64_t inner = *nested - nested_at_start;
+    *nested = nested_at_start + total;
+    return total > inner ? total - inner : 0;
+}
+
+// Charge the span's own time and allocations (minus inner spans) to the stage
+void stats_record(stats_stage_t stage, stats_span_t span) {
+    uint64_t ns = claim(stats_now() - span.start, &stats_nested_ns, span.nested);
+    uint64_t allocs = claim(__atomic_load_n(&memory.allocs, __ATOMIC_RELAXED) - span.allocs,
+                            &stats_nested_allocs, span.nested_allocs);
+    uint64_t bytes = claim(__atomic_load_n(&memory.bytes, __ATOMIC_RELAXED) - span.bytes,
+                           &stats_nested_bytes, span.nested_bytes);
+    histogram_add(&stages[stage], ns, allocs, bytes);
+}
+
+// Whole-frame latency and allocations, inner spans included
+void stats_record_frame(stats_span_t span) {
+    histogram_add(&frames, stats_now() - span.start,
+                  __atomic_load_n(&memory.allocs, __ATOMIC_RELAXED) - span.allocs,
+                  __atomic_load_n(&memory.bytes, __ATOMIC_RELAXED) - span.bytes);
+}
+
+// Frames handled as one block: each gets an equal share of the block's
+// time and allocations, so the frame histogram stays per frame
+void stats_record_frames(stats_span_t span, int count) {
+    if (count <= 0) return;
+    uint64_t ns = stats_now() - span.start;
+    uint64_t allocs = __atomic_load_n(&memory.allocs, __ATOMIC_RELAXED) - span.allocs;
+    uint64_t bytes = __atomic_load_n(&memory.bytes, __ATOMIC_RELAXED) - span.bytes;
+    for (int i = 0; i < count; i++) {
+        // Remainders go to the first frames, so the totals are exact
+        uint64_t k = (uint64_t)i;
+        histogram_add(&frames, ns / count + (k < ns % count),
+                      allocs / count + (k < allocs % count),
+                      bytes / count + (k < bytes % count));
+    }
+}
+
+static void report_row(FILE* out, const char* name, const stats_histogram_t* h, uint64_t wall_ns) {
+    if (h->count == 0) return;
+    fprintf(out, "%-10s %9llu %10.2f %6.1f%% %9.2f %9.2f %9.2f %9llu %10.1f\n", name,
+            (unsigned long long)h->count,
+            h->total_ns / 1e6,
+            wall_ns ? 100.0 * h->total_ns / wall_ns : 0.0,
+            h->total_ns / 1e3 / h->count,
+            histogram_percentile(h, 0.50) / 1e3,
+            histogram_percentile(h, 0.99) / 1e3,
+            (unsigned long long)h->allocs,
+            h->bytes / 1024.0);
+}
+
+void stats_report(FILE* out, double audio_seconds) {
+    uint64_t wall_ns = stats_now() - run_start_ns;
+
+    fprintf(out, "\n%-10s %9s %10s %7s %9s %9s %9s %9s %10s\n",
+            "stage", "calls", "total ms", "share", "mean us", "p50 us", "p99 us",
+            "allocs", "alloc KB");
+    for (int s = 0; s < STATS_STAGE_COUNT; s++) {
+        report_row(out, stage_names[s], &stages[s], wall_ns);
+    }
+    report_row(out, "frame", &frames, wall_ns);
+
+    double wall = wall_ns / 1e9;
+    fprintf(out, "%.2f s of audio in %.3f s", audio_seconds, wall);
+    if (wall > 0 && audio_seconds > 0) {
+        fprintf(out, ": real-time factor %.4f (%.1fx faster than real time)",
+                wall / audio_seconds, audio_seconds / wall);
+    }
+    fprintf(out, "\n");
+
+    struct rusage usage;
+    double peak_rss_mb = 0;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        peak_rss_mb = usage.ru_maxrss / 1024.0;   // ru_maxrss is in KB on Linux
+    }
+    fprintf(out, "Heap: %llu allocations, %.1f MB allocated, peak live %.1f MB; peak RSS %.1f MB\n",
+            (unsigned long long)memory.allocs, memory.bytes / 1048576.0,
+            memory.peak_bytes / 1048576.0, peak_rss_mb);
+    if (frames.count > 0) {
+        fprintf(out, "Per frame: %.2f allocations on average, at most %llu\n",
+                (double)frames.allocs / frames.count, (unsigned long long)frames.max_allocs);
+    }
+}
+
+void stats_file_begin(double audio_seconds) {
+    file.start_ns = stats_now();
+    file.audio_seconds = audio_seconds;
+    file.allocs = __atomic_load_n(&memory.allocs, __ATOMIC_RELAXED);
+    file.bytes = __atomic_load_n(&memory.bytes, __ATOMIC_RELAXED);
+    memcpy(file.stages, stages, sizeof(stages));
+    file.frames = frames.count;
+    __atomic_store_n(&memory.file_peak_bytes, __atomic_load_n(&memory.live_bytes, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+}
+
+// One line per file, then the stages it used. Allocations made meanwhile
+// on the prefetch thread (for the files after it) count towards this one.
+void stats_file_report(FILE* out, const char* name, double audio_seconds) {
+    uint64_t wall_ns = stats_now() - file.start_ns;
+    fprintf(out, "%s: %.2f s of audio in %.3f s, %llu frames; heap %llu allocations, "
+            "%.1f MB allocated, peak live %.1f MB\n",
+            name, audio_seconds - file.audio_seconds, wall_ns / 1e9,
+            (unsigned long long)(frames.count - file.frames),
+            (unsigned long long)(__atomic_load_n(&memory.allocs, __ATOMIC_RELAXED) - file.allocs),
+            (__atomic_load_n(&memory.bytes, __ATOMIC_RELAXED) - file.bytes) / 1048576.0,
+            __atomic_load_n(&memory.file_peak_bytes, __ATOMIC_RELAXED) / 1048576.0);
+    for (int s = 0; s < STATS_STAGE_COUNT; s++) {
+        const stats_histogram_t* h = &stages[s];
+        const stats_histogram_t* before = &file.stages[s];
+        if (h->count == before->count) continue;
+        fprintf(out, "  %-10s %9llu %10.2f ms %9llu allocs %10.1f KB\n", stage_names[s],
+                (unsigned long long)(h->count - before->count),
+                (h->total_ns - before->total_ns) / 1e6,
+                (unsigned long long)(h->allocs - before->allocs),
+                (h->bytes - before->bytes) / 1024.0);
+    }
+}
+
+// Blocks from fft_malloc/fft_calloc still live; call after all cleanup
+bool stats_report_leaks(FILE* out) {
+    uint64_t live = memory.allocs - memory.frees;
+    if (live == 0) {
+        fprintf(out, "Leak check: all %llu allocations released\n",
+                (unsigned long long)memory.allocs);
+        return true;
+    }
+    fprintf(out, "Leak check: %llu allocations (%llu bytes) still live at shutdown\n",
+            (unsigned long long)live, (unsigned long long)memory.live_bytes);
+    return false;
+}
+
+#endif
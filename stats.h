@@ -0,0 +1,101 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Pipeline instrumentation behind --stats. Built only with PITCH_STATS
+// defined (CMake option of the same name); otherwise the STATS_* macros
+// expand to nothing and the hot path carries no timer calls at all.
+//
+// Stage times and allocations are exclusive: a span that encloses other
+// spans (detection calling the magnitude pass, ...) is charged only for
+// its own share. Recording is meant for the analysis thread only; the
+// allocation counters themselves are atomic.
+
+typedef enum {
+    STATS_LOAD = 0,      // WAV load/decode
+    STATS_FILTER,        // prefilter over the whole recording
+    STATS_CONVERT,       // int16 -> complex frame
+    STATS_WINDOW,
+    STATS_TRANSFORM,     // radix2_dit_fft / compute_ndft / fft_many
+    STATS_MAGNITUDE,
+    STATS_DETECT,
+    STATS_OUTPUT,        // handing records to the result sink
+    STATS_STAGE_COUNT
+} stats_stage_t;
+
+typedef struct {
+    uint64_t start;      // monotonic ns, 0 when stats are off
+    uint64_t nested;     // time charged to inner spans when this one began
+    uint64_t allocs;     // allocation counters when this one began
+    uint64_t bytes;
+    uint64_t nested_allocs;
+    uint64_t nested_bytes;
+} stats_span_t;
+
+#ifdef PITCH_STATS
+
+extern bool stats_active;
+
+// Instrumented allocator: counts allocations, bytes, live and peak heap
+// (sizes from malloc_usable_size). Blocks from fft_malloc/fft_calloc must
+// be released with fft_free; a plain free() shows up as a leak.
+void* stats_malloc(size_t size);
+void* stats_calloc(size_t count, size_t size);
+void stats_free(void* ptr);
+bool stats_report_leaks(FILE* out);
+void stats_span_allocations(stats_span_t* span);
+
+#define fft_malloc stats_malloc
+#define fft_calloc stats_calloc
+#define fft_free stats_free
+
+void stats_enable(void);
+uint64_t stats_now(void);
+void stats_record(stats_stage_t stage, stats_span_t span);
+void stats_record_frame(stats_span_t span);
+void stats_record_frames(stats_span_t span, int count);
+void stats_report(FILE* out, double audio_seconds);
+// Per-recording breakdown (corpus runs): counters are snapshot when a file
+// starts and the difference is reported when it ends. audio_seconds is
+// the running total of audio analyzed, before and after the file.
+void stats_file_begin(double audio_seconds);
+void stats_file_report(FILE* out, const char* name, double audio_seconds);
+
+static inline stats_span_t stats_begin(void) {
+    extern uint64_t stats_nested_ns;
+    stats_span_t span = {0, 0, 0, 0, 0, 0};
+    if (stats_active) {
+        span.start = stats_now();
+        span.nested = stats_nested_ns;
+        stats_span_allocations(&span);
+    }
+    return span;
+}
+
+#define STATS_BEGIN(span) stats_span_t span = stats_begin()
+#define STATS_END(stage, span) do { if (stats_active) stats_record(stage, span); } while (0)
+#define STATS_END_FRAME(span) do { if (stats_active) stats_record_frame(span); } while (0)
+// A span covering `count` frames processed together (blocked, batched)
+#define STATS_END_FRAMES(span, count) do { if (stats_active) stats_record_frames(span, count); } while (0)
+#define STATS_FILE_BEGIN(seconds) do { if (stats_active) stats_file_begin(seconds); } while (0)
+#define STATS_FILE_END(name, seconds) do { if (stats_active) stats_file_report(stderr, name, seconds); } while (0)
+
+#else
+
+#define fft_malloc malloc
+#define fft_calloc calloc
+#define fft_free free
+
+#define STATS_BEGIN(span)
+#define STATS_END(stage, span) do { } while (0)
+#define STATS_END_FRAME(span) do { } while (0)
+#define STATS_END_FRAMES(span, count) do { } while (0)
+#define STATS_FILE_BEGIN(seconds) do { } while (0)
+#define STATS_FILE_END(name, seconds) do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,89 @@
+#include "fft_common.h"
+#include "fft_algorithms.h"
+
+/**
+ * @file stockham.c
+ * @brief Stockham autosort FFT (radix-2, out-of-place)
+ *
+ * @details
+ * The Stockham formulation reorders the data a little in every stage
+ * instead of doing one bit-reversal pass up front. Each stage reads one
+ * buffer and writes the other (ping-pong), and all accesses are
+ * sequential runs, so there are no random-access swaps at large n.
+ *
+ * Stage with half-length l and stride s (l * s = n/2):
+ *   a = x[k + s*j], b = x[k + s*(j + l)]
+ *   y[k + s*2j]     = a + b
+ *   y[k + s*(2j+1)] = (a - b) * W_{2l}^j
+ *
+ * Space Complexity: O(n) scratch buffer
+ *
+ * References:
+ * [1] Van Loan, C. (1992). "Computational Frameworks for the Fast
+ *     Fourier Transform", section 1.7
+ */
+
+/**
+ * @brief Stockham FFT with a caller-provided scratch buffer
+ *
+ * @param x Input/output array of complex numbers
+ * @param y Scratch array of the same length
+ * @param n Length of array (must be power of 2)
+ * @param dir Transform direction (FFT_FORWARD or FFT_INVERSE)
+ */
+void stockham_fft_buffer(complex_t* x, complex_t* y, int n, fft_direction dir) {
+    CHECK_POWER_OF_TWO(n);
+    if (n == 1) return;
+
+    const complex_t* tw = fft_twiddles(n, dir);
+    complex_t* src = x;
+    complex_t* dst = y;
+
+    for (int l = n >> 1, s = 1; l >= 1; l >>= 1, s <<= 1) {
+        int tw_stride = s;  /* W_{2l}^j = W_n^{j * n/(2l)} and n/(2l) = s */
+
+        for (int j = 0; j < l; j++) {
+            complex_t w = tw[j * tw_stride];
+            const complex_t* a = src + s * j;
+            const complex_t* b = src + s * (j + l);
+            complex_t* even = dst + s * 2 * j;
+            complex_t* odd = even + s;
+
+            for (int k = 0; k < s; k++) {
+                complex_t u = a[k];
+                complex_t v = b[k];
+                even[k] = u + v;
+                odd[k] = (u - v) * w;
+            }
+        }
+
+        complex_t* t = src;
+        src = dst;
+        dst = t;
+    }
+
+    /* An odd number of stages leaves the result in the scratch buffer */
+    if (src != x) {
+        memcpy(x, src, n * sizeof(complex_t));
+    }
+
+    if (dir == FFT_INVERSE) {
+        for (int i = 0; i < n; i++) {
+            x[i] /= n;
+        }
+    }
+}
+
+/**
+ * @brief Stockham FFT, allocating its own scratch buffer
+ *
+ * @param x Input/output array of complex numbers
+ * @param n Length of array (must be power of 2)
+ * @param dir Transform direction (FFT_FORWARD or FFT_INVERSE)
+ */
+void stockham_fft(complex_t* x, int n, fft_direction dir) {
+    complex_t* y = allocate_complex_array(n);
+    CHECK_NULL(y, "Failed to allocate Stockham scratch buffer");
+    stockham_fft_buffer(x, y, n, dir);
+    free_complex_array(y);
+}
@@ -0,0 +1,181 @@
+#include "synth.h"
+#include "wavformat.h"
+#include "audio_spectrum.h"
+#include "pitch_detection.h"
+
+// Segment kinds and how often they are drawn (cumulative, out of 100)
+typedef enum {
+    SYNTH_NOTE = 0,          // generate_musical_note, random harmonic mix
+    SYNTH_CHORD,             // major or minor triad of generate_musical_note
+    SYNTH_TEST_CHORD,        // generate_test_audio (A major with noise)
+    SYNTH_SILENCE,           // background noise only
+    SYNTH_NOISE,             // loud white noise, no pitch
+    SYNTH_KIND_COUNT
+} synth_kind_t;
+
+static const char* kind_names[SYNTH_KIND_COUNT] = {"note", "chord", "chord", "silence", "noise"};
+static const int kind_cumulative[SYNTH_KIND_COUNT] = {55, 75, 80, 90, 100};
+
+// Note table range for generated pitches: E2 (guitar low E) .. C6
+#define SYNTH_LOWEST_NOTE 28
+#define SYNTH_HIGHEST_NOTE 72
+#define SYNTH_A4_INDEX 57
+#define SYNTH_MAX_HARMONICS 8
+#define SYNTH_FADE_SECONDS 0.005
+
+synth_config_t synth_default_config(void) {
+    synth_config_t config;
+    config.duration = 60.0;
+    config.sample_rate = 44100;
+    config.seed = 1;
+    config.noise = 0.002;
+    config.min_segment = 0.25;
+    config.max_segment = 2.0;
+    return config;
+}
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * ((double)rand() / RAND_MAX);
+}
+
+static double note_frequency(int idx) {
+    return 440.0 * pow(2.0, (idx - SYNTH_A4_INDEX) / 12.0);
+}
+
+static synth_kind_t draw_kind(void) {
+    int r = rand() % 100;
+    for (int k = 0; k < SYNTH_KIND_COUNT; k++) {
+        if (r < kind_cumulative[k]) return k;
+    }
+    return SYNTH_NOTE;
+}
+
+// One note with 3..8 harmonics of random, roughly 1/h, strength; peak
+// amplitude scaled to `level`
+static void add_note(complex_t* mix, complex_t* scratch, int len, double freq,
+                     double sample_rate, double level) {
+    double amps[SYNTH_MAX_HARMONICS];
+    int harmonics = 3 + rand() % (SYNTH_MAX_HARMONICS - 2);
+    // Keep every partial below Nyquist
+    while (harmonics > 1 && freq * harmonics >= sample_rate / 2) harmonics--;
+    double total = 0;
+    for (int h = 0; h < harmonics; h++) {
+        amps[h] = uniform(0.5, 1.0) / (h + 1);
+        total += amps[h];
+    }
+    generate_musical_note(scratch, len, freq, sample_rate, harmonics, amps);
+    for (int i = 0; i < len; i++) {
+        mix[i] += scratch[i] * (level / total);
+    }
+}
+
+// Fill one segment, return its label frequency (0 when it has no pitch)
+static double synth_segment(synth_kind_t kind, complex_t* mix, complex_t* scratch, int len,
+                            double sample_rate, int* note) {
+    for (int i = 0; i < len; i++) mix[i] = 0;
+    *note = -1;
+
+    switch (kind) {
+    case SYNTH_NOTE: {
+        *note = SYNTH_LOWEST_NOTE + rand() % (SYNTH_HIGHEST_NOTE - SYNTH_LOWEST_NOTE + 1);
+        add_note(mix, scratch, len, note_frequency(*note), sample_rate, uniform(0.2, 0.8));
+        return note_frequency(*note);
+    }
+    case SYNTH_CHORD: {
+        *note = SYNTH_LOWEST_NOTE + rand() % (SYNTH_HIGHEST_NOTE - 7 - SYNTH_LOWEST_NOTE + 1);
+        int third = (rand() & 1) ? 4 : 3;
+        double level = uniform(0.1, 0.3);
+        add_note(mix, scratch, len, note_frequency(*note), sample_rate, level);
+        add_note(mix, scratch, len, note_frequency(*note + third), sample_rate, level);
+        add_note(mix, scratch, len, note_frequency(*note + 7), sample_rate, level);
+        return note_frequency(*note);
+    }
+    case SYNTH_TEST_CHORD:
+        generate_test_audio(mix, len, sample_rate);
+        for (int i = 0; i < len; i++) mix[i] *= 0.5;
+        *note = SYNTH_A4_INDEX;
+        return 440.0;
+    case SYNTH_NOISE: {
+        double level = uniform(0.05, 0.3);
+        for (int i = 0; i < len; i++) mix[i] = uniform(-level, level);
+        return 0;
+    }
+    default:
+        return 0;
+    }
+}
+
+// Generate config->duration seconds of audio into wav_path and its labels
+// into labels_path, one segment in memory at a time
+bool synth_generate(const char* wav_path, const char* labels_path, const synth_config_t* config) {
+    double sample_rate = config->sample_rate;
+    uint64_t total = (uint64_t)(config->duration * sample_rate);
+    if (total > WAV_MAX_SAMPLES || config->min_segment <= 0 ||
+        config->max_segment < config->min_segment) {
+        PRINT_ERROR("Invalid synthetic recording: %.1f s at %d Hz, segments %.2f..%.2f s",
+                    config->duration, config->sample_rate, config->min_segment, config->max_segment);
+        return false;
+    }
+
+    FILE* labels = fopen(labels_path, "w");
+    if (labels == NULL) {
+        PRINT_ERROR("%s: Failed to open file", labels_path);
+        return false;
+    }
+    wav_writer_t writer;
+    if (!WavWriterOpen(&writer, wav_path, config->sample_rate)) {
+        fclose(labels);
+        return false;
+    }
+
+    int max_len = (int)ceil(config->max_segment * sample_rate);
+    complex_t* mix = allocate_complex_array(max_len);
+    complex_t* scratch = allocate_complex_array(max_len);
+    int16_t* pcm = fft_malloc(max_len * sizeof(int16_t));
+    CHECK_NULL(mix, "Failed to allocate synthesis buffers");
+    CHECK_NULL(scratch, "Failed to allocate synthesis buffers");
+    CHECK_NULL(pcm, "Failed to allocate synthesis buffers");
+
+    srand(config->seed);
+    fprintf(labels, "start,end,kind,frequency,note\n");
+    int fade = (int)(SYNTH_FADE_SECONDS * sample_rate);
+    bool ok = true;
+    uint64_t written = 0;
+
+    while (ok && written < total) {
+        int len = (int)(uniform(config->min_segment, config->max_segment) * sample_rate);
+        if (len < 1) len = 1;
+        if (len > max_len) len = max_len;
+        if ((uint64_t)len > total - written) len = (int)(total - written);
+
+        synth_kind_t kind = draw_kind();
+        int note;
+        double freq = synth_segment(kind, mix, scratch, len, sample_rate, &note);
+
+        for (int i = 0; i < len; i++) {
+            // Short linear fades so segment boundaries do not click
+            double gain = 1.0;
+            if (i < fade) gain = (double)i / fade;
+            if (len - 1 - i < fade) gain = fmin(gain, (double)(len - 1 - i) / fade);
+            double v = creal(mix[i]) * gain + uniform(-config->noise, config->noise);
+            pcm[i] = (int16_t)fmax(-32768.0, fmin(32767.0, round(v * 32767.0)));
+        }
+        ok = WavWriterWrite(&writer, pcm, len);
+
+        fprintf(labels, "%.6f,%.6f,%s,%.2f,%s\n", written / sample_rate,
+                (written + len) / sample_rate, kind_names[kind], freq,
+                note >= 0 ? note_name(note) : "");
+        written += len;
+    }
+
+    fft_free(pcm);
+    free_complex_array(scratch);
+    free_complex_array(mix);
+    if (!WavWriterClose(&writer)) ok = false;
+    if (ferror(labels)) ok = false;
+    if (fclose(labels) != 0) ok = false;
+    if (!ok) {
+        PRINT_ERROR("%s: Failed to write synthetic recording", wav_path);
+    }
+    return ok;
+}
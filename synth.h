@@ -0,0 +1,24 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Synthetic test recordings for throughput and memory scaling runs: a
+// random sequence of notes, chords, silence and noise of any length,
+// written with WavWriter* a segment at a time, plus a ground-truth CSV
+// (start, end, kind, frequency, note) next to it.
+
+typedef struct {
+    double duration;         // seconds of audio to generate
+    int32_t sample_rate;
+    unsigned seed;           // srand() seed, same seed gives the same file
+    double noise;            // background noise amplitude, fraction of full scale
+    double min_segment;      // segment length range in seconds
+    double max_segment;
+} synth_config_t;
+
+synth_config_t synth_default_config(void);
+bool synth_generate(const char* wav_path, const char* labels_path, const synth_config_t* config);
+
+#endif
@@ -8,7 +8,7 @@ bool LoadWav(const char *filename, sound_t *sound) {
 	int32_t format_length;		// 16
 	int16_t format_type;		// 1 = PCM
 	int16_t num_channels;		// 1
-	int32_t sample_rate;		// 44100
+	int32_t sample_rate;		// WAV_MIN_SAMPLE_RATE..WAV_MAX_SAMPLE_RATE
 	int32_t bytes_per_second;
 	int16_t block_align;		// num_channels * bits_per_sample / 8
 	int16_t bits_per_sample;	// 16
@@ -63,8 +63,9 @@ bool LoadWav(const char *filename, sound_t *sound) {
 	}
 
 	fread(&sample_rate, 4, 1, file);
-	if(sample_rate != 44100) {
-		PRINT_ERROR("%s Sample rate should be 44100, is %d", filename, sample_rate);
+	if(sample_rate < WAV_MIN_SAMPLE_RATE || sample_rate > WAV_MAX_SAMPLE_RATE) {
+		PRINT_ERROR("%s Sample rate should be %d..%d, is %d", filename,
+			WAV_MIN_SAMPLE_RATE, WAV_MAX_SAMPLE_RATE, sample_rate);
 		return_value = false;
 		goto CLOSE_FILE;
 	}
@@ -124,6 +125,7 @@ bool LoadWav(const char *filename, sound_t *sound) {
 
 		sound->samples = data_size / 2;
 		sound->bytes_per_second = bytes_per_second;
+		sound->sample_rate = sample_rate;
 	}
 	else if(magic[0] == 'd' && magic[1] == 'a' && magic[2] == 't' && magic[3] == 'a') {
 		fread(&data_size, 4, 1, file);
@@ -144,10 +146,8 @@ bool LoadWav(const char *filename, sound_t *sound) {
 
 		sound->samples = data_size / 2;
 		sound->bytes_per_second = bytes_per_second;
+		sound->sample_rate = sample_rate;
 		fclose(file);
-		printf("Sound samples: %d\n",sound->samples);
-		printf("Bytes per second: %d\n",sound->bytes_per_second);
-
 		return return_value;
 	}
 	else{
@@ -157,7 +157,82 @@ bool LoadWav(const char *filename, sound_t *sound) {
 	}
 	CLOSE_FILE:
 	fclose(file);
-	printf("Sound samples: %d\n",sound->samples);
-	printf("Bytes per second: %d\n",sound->bytes_per_second);
 	return return_value;
-}
\ No newline at end of file
+}
+
+bool WavWriterOpen(wav_writer_t *writer, const char *filename, int32_t sample_rate) {
+	int32_t format_length = 16;
+	int16_t format_type = 1;
+	int16_t num_channels = 1;
+	int32_t bytes_per_second = sample_rate * 2;
+	int16_t block_align = 2;
+	int16_t bits_per_sample = 16;
+	int32_t size = 0;		// RIFF and data sizes, patched by WavWriterClose
+
+	writer->samples = 0;
+	writer->file = fopen(filename, "wb");
+	if(writer->file == NULL) {
+		PRINT_ERROR("%s: Failed to open file", filename);
+		return false;
+	}
+
+	fwrite("RIFF", 1, 4, writer->file);
+	fwrite(&size, 4, 1, writer->file);
+	fwrite("WAVE", 1, 4, writer->file);
+	fwrite("fmt ", 1, 4, writer->file);
+	fwrite(&format_length, 4, 1, writer->file);
+	fwrite(&format_type, 2, 1, writer->file);
+	fwrite(&num_channels, 2, 1, writer->file);
+	fwrite(&sample_rate, 4, 1, writer->file);
+	fwrite(&bytes_per_second, 4, 1, writer->file);
+	fwrite(&block_align, 2, 1, writer->file);
+	fwrite(&bits_per_sample, 2, 1, writer->file);
+	fwrite("data", 1, 4, writer->file);
+	if(fwrite(&size, 4, 1, writer->file) != 1) {
+		PRINT_ERROR("%s: Failed to write header", filename);
+		fclose(writer->file);
+		writer->file = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool WavWriterWrite(wav_writer_t *writer, const int16_t *data, uint32_t count) {
+	if(count > WAV_MAX_SAMPLES - writer->samples) {
+		PRINT_ERROR("WAV data would exceed %u samples", WAV_MAX_SAMPLES);
+		return false;
+	}
+	if(fwrite(data, 2, count, writer->file) != count) {
+		PRINT_ERROR("Failed to write %u samples", count);
+		return false;
+	}
+	writer->samples += count;
+	return true;
+}
+
+bool WavWriterClose(wav_writer_t *writer) {
+	bool return_value = true;
+	int32_t data_size = writer->samples * 2;
+	int32_t filesize = 36 + data_size;
+
+	if(fseek(writer->file, 4, SEEK_SET) != 0 || fwrite(&filesize, 4, 1, writer->file) != 1 ||
+	   fseek(writer->file, 40, SEEK_SET) != 0 || fwrite(&data_size, 4, 1, writer->file) != 1) {
+		PRINT_ERROR("Failed to write WAV sizes");
+		return_value = false;
+	}
+	if(fclose(writer->file) != 0) {
+		PRINT_ERROR("Failed to close WAV file");
+		return_value = false;
+	}
+	writer->file = NULL;
+	return return_value;
+}
+
+bool SaveWav(const char *filename, const sound_t *sound) {
+	wav_writer_t writer;
+	if(!WavWriterOpen(&writer, filename, sound->sample_rate)) {
+		return false;
+	}
+	bool return_value = WavWriterWrite(&writer, sound->data, sound->samples);
+	return WavWriterClose(&writer) && return_value;
+}
@@ -3,14 +3,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
-#define PRINT_ERROR(a, args...) printf("ERROR %s() %s Line %d: " a "\n", __FUNCTION__, __FILE__, __LINE__, ##args);
+#define PRINT_ERROR(a, args...) fprintf(stderr, "ERROR %s() %s Line %d: " a "\n", __FUNCTION__, __FILE__, __LINE__, ##args);
+
+// Sample rates LoadWav accepts (16-bit mono PCM at any of these)
+#define WAV_MIN_SAMPLE_RATE 8000
+#define WAV_MAX_SAMPLE_RATE 192000
+
+// Largest data chunk LoadWav can read (its size field is an int32_t)
+#define WAV_MAX_SAMPLES ((uint32_t)((INT32_MAX - 36) / 2))
 
 typedef struct {
 	uint32_t samples;
 	int16_t *data;
 	int32_t bytes_per_second;	// sample_rate * num_channels * bits_per_sample / 8
+	int32_t sample_rate;
 } sound_t;
 
+// Streaming writer for long 16-bit mono files; sizes are patched on close
+typedef struct {
+	FILE *file;
+	uint32_t samples;
+} wav_writer_t;
+
 typedef struct
 {
 	char *id;
@@ -18,4 +32,8 @@ typedef struct
 } list_t;
 
 
-bool LoadWav(const char *filename, sound_t *sound);
\ No newline at end of file
+bool LoadWav(const char *filename, sound_t *sound);
+bool SaveWav(const char *filename, const sound_t *sound);
+bool WavWriterOpen(wav_writer_t *writer, const char *filename, int32_t sample_rate);
+bool WavWriterWrite(wav_writer_t *writer, const int16_t *data, uint32_t count);
+bool WavWriterClose(wav_writer_t *writer);
\ No newline at end of file